@@ -0,0 +1,107 @@
+#include "adjacency_storage.h"
+#include <bitset>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+inline int popcount64(std::uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    return static_cast<int>(std::bitset<64>(x).count());
+#endif
+}
+
+// Rounds up to a whole number of 64-byte cache lines.
+std::size_t paddedCount(std::size_t count, std::size_t elementSize) {
+    std::size_t perLine = 64 / elementSize;
+    return (count + perLine - 1) / perLine * perLine;
+}
+
+bool isUnweighted(const Graph& g) {
+    for (const auto& row : g.adjacencyMatrix) {
+        for (int w : row) {
+            if (w != 0 && w != 1) return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+AdjacencyStorage::AdjacencyStorage(const Graph& g)
+    : AdjacencyStorage(g, isUnweighted(g) ? Backend::PackedBits : Backend::FlatWeights) {}
+
+AdjacencyStorage::AdjacencyStorage(const Graph& g, Backend backend) : n(g.numVertices), kind(backend) {
+    if (kind == Backend::PackedBits && !isUnweighted(g))
+        throw std::invalid_argument("PackedBits storage needs 0/1 weights.");
+
+    bitStride = paddedCount((static_cast<std::size_t>(n) + 63) / 64, sizeof(std::uint64_t));
+    bits.assign(bitStride * n, 0);
+    if (kind == Backend::FlatWeights) {
+        weightStride = paddedCount(n, sizeof(std::int32_t));
+        weights.assign(weightStride * n, 0);
+    }
+
+    for (int i = 0; i < n; ++i) {
+        std::uint64_t* row = bits.data() + i * bitStride;
+        for (int j = 0; j < n; ++j) {
+            int w = g.adjacencyMatrix[i][j];
+            if (w == 0) continue;
+            row[j >> 6] |= std::uint64_t(1) << (j & 63);
+            if (kind == Backend::FlatWeights) weights[i * weightStride + j] = w;
+        }
+    }
+}
+
+int AdjacencyStorage::degree(int i) const {
+    const std::uint64_t* row = bitRow(i);
+    int count = 0;
+    for (std::size_t k = 0; k < bitStride; ++k) count += popcount64(row[k]);
+    return count;
+}
+
+int AdjacencyStorage::commonNeighbors(int i, int j) const {
+    const std::uint64_t* a = bitRow(i);
+    const std::uint64_t* b = bitRow(j);
+    int count = 0;
+    for (std::size_t k = 0; k < bitStride; ++k) count += popcount64(a[k] & b[k]);
+    return count;
+}
+
+bool AdjacencyStorage::rowEquals(int i, const AdjacencyStorage& other, int j) const {
+    if (n != other.n) return false;
+    // Padding is zero in both, so whole padded rows can be compared.
+    if (std::memcmp(bitRow(i), other.bitRow(j), bitStride * sizeof(std::uint64_t)) != 0) return false;
+    if (kind == Backend::FlatWeights && other.kind == Backend::FlatWeights)
+        return std::memcmp(weightRow(i), other.weightRow(j), weightStride * sizeof(std::int32_t)) == 0;
+    if (kind == Backend::PackedBits && other.kind == Backend::PackedBits) return true;
+
+    for (int k = 0; k < n; ++k) {
+        if (weight(i, k) != other.weight(j, k)) return false;
+    }
+    return true;
+}
+
+bool AdjacencyStorage::sameMatrix(const AdjacencyStorage& other) const {
+    if (n != other.n) return false;
+    for (int i = 0; i < n; ++i) {
+        if (!rowEquals(i, other, i)) return false;
+    }
+    return true;
+}
+
+std::size_t AdjacencyStorage::memoryBytes() const {
+    return bits.capacity() * sizeof(std::uint64_t) + weights.capacity() * sizeof(std::int32_t);
+}
+
+Graph AdjacencyStorage::toGraph() const {
+    Graph g;
+    g.numVertices = n;
+    g.adjacencyMatrix.assign(n, std::vector<int>(n, 0));
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) g.adjacencyMatrix[i][j] = weight(i, j);
+    }
+    return g;
+}
@@ -0,0 +1,82 @@
+#ifndef ADJACENCY_STORAGE_H
+#define ADJACENCY_STORAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+#include "graph_utils.h"
+
+// Allocator handing out 64-byte aligned blocks, so every matrix row can
+// start on a cache line.
+template <typename T>
+struct CacheAlignedAllocator {
+    using value_type = T;
+    static constexpr std::size_t alignment = 64;
+
+    CacheAlignedAllocator() = default;
+    template <typename U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U>&) {}
+
+    T* allocate(std::size_t count) {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignment)));
+    }
+    void deallocate(T* p, std::size_t) { ::operator delete(p, std::align_val_t(alignment)); }
+
+    template <typename U>
+    bool operator==(const CacheAlignedAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const CacheAlignedAllocator<U>&) const { return false; }
+};
+
+// Dense adjacency matrix in a single allocation with cache-line aligned,
+// zero padded rows. Both backends keep an edge bitset that the popcount
+// kernels run on; FlatWeights also stores the weights row-major, while
+// PackedBits holds graphs whose weights are all 0/1 in one bit per cell.
+class AdjacencyStorage {
+public:
+    enum class Backend { FlatWeights, PackedBits };
+
+    AdjacencyStorage() = default;
+    // Picks PackedBits when every weight is 0 or 1.
+    explicit AdjacencyStorage(const Graph& g);
+    // Throws std::invalid_argument for PackedBits on a weighted graph.
+    AdjacencyStorage(const Graph& g, Backend backend);
+
+    int numVertices() const { return n; }
+    Backend backend() const { return kind; }
+
+    bool hasEdge(int i, int j) const {
+        return (bitRow(i)[j >> 6] >> (j & 63)) & 1;
+    }
+    int weight(int i, int j) const {
+        return kind == Backend::FlatWeights ? weights[i * weightStride + j] : static_cast<int>(hasEdge(i, j));
+    }
+
+    const std::uint64_t* bitRow(int i) const { return bits.data() + i * bitStride; }
+    const std::int32_t* weightRow(int i) const {
+        return kind == Backend::FlatWeights ? weights.data() + i * weightStride : nullptr;
+    }
+
+    // Number of out-neighbors of i, self-loop included.
+    int degree(int i) const;
+    // |N(i) & N(j)| over out-neighbors, by popcount over the row words.
+    int commonNeighbors(int i, int j) const;
+    // Row i of this matrix against row j of other, column for column.
+    bool rowEquals(int i, const AdjacencyStorage& other, int j) const;
+    // Same vertex count and identical matrices, without relabeling.
+    bool sameMatrix(const AdjacencyStorage& other) const;
+
+    std::size_t memoryBytes() const;
+    Graph toGraph() const;
+
+private:
+    int n = 0;
+    Backend kind = Backend::PackedBits;
+    std::size_t bitStride = 0;     // 64-bit words per row
+    std::size_t weightStride = 0;  // weights per row
+    std::vector<std::uint64_t, CacheAlignedAllocator<std::uint64_t>> bits;
+    std::vector<std::int32_t, CacheAlignedAllocator<std::int32_t>> weights;
+};
+
+#endif // ADJACENCY_STORAGE_H
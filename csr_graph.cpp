@@ -0,0 +1,135 @@
+#include "csr_graph.h"
+#include "graph_utils.h"
+#include <algorithm>
+#include <stdexcept>
+
+CsrGraph CsrGraph::fromGraph(const Graph& g) {
+    CsrGraph c;
+    int n = g.numVertices;
+    c.n = n;
+    c.loop.assign(n, 0);
+    c.outStart.assign(n + 1, 0);
+
+    for (int i = 0; i < n; ++i) {
+        c.loop[i] = g.adjacencyMatrix[i][i];
+        for (int j = 0; j < n; ++j) {
+            int w = g.adjacencyMatrix[i][j];
+            if (w != g.adjacencyMatrix[j][i]) c.isSymmetric = false;
+            if (i == j || w == 0) continue;
+            c.outAdj.push_back(j);
+            c.outWeight.push_back(w);
+        }
+        c.outStart[i + 1] = static_cast<int>(c.outAdj.size());
+    }
+    if (!c.isSymmetric) c.buildInArrays();
+    return c;
+}
+
+CsrGraph CsrGraph::fromEdges(int numVertices, std::vector<CsrEdge> edges) {
+    CsrGraph c;
+    int n = numVertices;
+    c.n = n;
+    c.loop.assign(n, 0);
+    c.outStart.assign(n + 1, 0);
+
+    std::sort(edges.begin(), edges.end(), [](const CsrEdge& a, const CsrEdge& b) {
+        return a.from != b.from ? a.from < b.from : a.to < b.to;
+    });
+    for (size_t k = 0; k < edges.size(); ++k) {
+        const CsrEdge& e = edges[k];
+        if (e.from < 0 || e.from >= n || e.to < 0 || e.to >= n)
+            throw std::invalid_argument("Edge endpoint out of range.");
+        if (e.weight == 0) throw std::invalid_argument("Edge weight must be non-zero.");
+        if (k > 0 && edges[k - 1].from == e.from && edges[k - 1].to == e.to)
+            throw std::invalid_argument("Duplicate edge.");
+
+        if (e.from == e.to) {
+            c.loop[e.from] = e.weight;
+            continue;
+        }
+        c.outAdj.push_back(e.to);
+        c.outWeight.push_back(e.weight);
+        ++c.outStart[e.from + 1];
+    }
+    for (int i = 0; i < n; ++i) c.outStart[i + 1] += c.outStart[i];
+
+    for (int i = 0; i < n && c.isSymmetric; ++i) {
+        for (int k = c.outStart[i]; k < c.outStart[i + 1]; ++k) {
+            if (c.weight(c.outAdj[k], i) != c.outWeight[k]) {
+                c.isSymmetric = false;
+                break;
+            }
+        }
+    }
+    if (!c.isSymmetric) c.buildInArrays();
+    return c;
+}
+
+// Transposes the out-arrays; filling in source order keeps every in-list
+// sorted.
+void CsrGraph::buildInArrays() {
+    inStart.assign(n + 1, 0);
+    for (int j : outAdj) ++inStart[j + 1];
+    for (int i = 0; i < n; ++i) inStart[i + 1] += inStart[i];
+
+    inAdj.resize(outAdj.size());
+    inWeight.resize(outWeight.size());
+    std::vector<int> fill(inStart.begin(), inStart.end() - 1);
+    for (int i = 0; i < n; ++i) {
+        for (int k = outStart[i]; k < outStart[i + 1]; ++k) {
+            int j = outAdj[k];
+            inAdj[fill[j]] = i;
+            inWeight[fill[j]++] = outWeight[k];
+        }
+    }
+}
+
+Graph CsrGraph::toGraph() const {
+    Graph g;
+    g.numVertices = n;
+    g.adjacencyMatrix.assign(n, std::vector<int>(n, 0));
+    for (int i = 0; i < n; ++i) {
+        g.adjacencyMatrix[i][i] = loop[i];
+        for (int k = outStart[i]; k < outStart[i + 1]; ++k) g.adjacencyMatrix[i][outAdj[k]] = outWeight[k];
+    }
+    return g;
+}
+
+int CsrGraph::weight(int from, int to) const {
+    if (from == to) return loop[from];
+    auto first = outAdj.begin() + outStart[from];
+    auto last = outAdj.begin() + outStart[from + 1];
+    auto it = std::lower_bound(first, last, to);
+    return it != last && *it == to ? outWeight[it - outAdj.begin()] : 0;
+}
+
+std::vector<CsrEdge> csrEdges(const CsrView& g) {
+    std::vector<CsrEdge> edges;
+    edges.reserve(g.numEdges());
+    for (int v = 0; v < g.numVertices; ++v) {
+        bool loopDone = g.loop[v] == 0;
+        for (int k = g.outStart[v]; k < g.outStart[v + 1]; ++k) {
+            if (!loopDone && g.outAdj[k] > v) {
+                edges.push_back({v, v, g.loop[v]});
+                loopDone = true;
+            }
+            edges.push_back({v, g.outAdj[k], g.outWeight[k]});
+        }
+        if (!loopDone) edges.push_back({v, v, g.loop[v]});
+    }
+    return edges;
+}
+
+CsrView CsrGraph::view() const {
+    CsrView v;
+    v.numVertices = n;
+    v.symmetric = isSymmetric;
+    v.outStart = outStart.data();
+    v.outAdj = outAdj.data();
+    v.outWeight = outWeight.data();
+    v.inStart = isSymmetric ? outStart.data() : inStart.data();
+    v.inAdj = isSymmetric ? outAdj.data() : inAdj.data();
+    v.inWeight = isSymmetric ? outWeight.data() : inWeight.data();
+    v.loop = loop.data();
+    return v;
+}
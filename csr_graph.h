@@ -0,0 +1,70 @@
+#ifndef CSR_GRAPH_H
+#define CSR_GRAPH_H
+
+#include <vector>
+
+struct Graph;
+
+// Non-owning compressed-sparse-row view; this is what the isomorphism
+// engine reads. Neighbors of v are adj[start[v] .. start[v + 1]), sorted by
+// vertex, with the matching weights alongside. Self-loops are kept apart in
+// `loop`. For symmetric graphs the in-arrays alias the out-arrays.
+struct CsrView {
+    int numVertices = 0;
+    bool symmetric = true;
+    const int* outStart = nullptr;
+    const int* outAdj = nullptr;
+    const int* outWeight = nullptr;
+    const int* inStart = nullptr;
+    const int* inAdj = nullptr;
+    const int* inWeight = nullptr;
+    const int* loop = nullptr;
+
+    int outDegree(int v) const { return outStart[v + 1] - outStart[v]; }
+    int inDegree(int v) const { return inStart[v + 1] - inStart[v]; }
+    // Directed edge count, self-loops excluded.
+    int numEdges() const { return numVertices > 0 ? outStart[numVertices] : 0; }
+};
+
+struct CsrEdge {
+    int from = 0;
+    int to = 0;
+    int weight = 1;
+};
+
+// Directed edge list of a view, self-loops included, ordered by source and
+// then target; CsrGraph::fromEdges(g.numVertices, csrEdges(g)) copies g.
+std::vector<CsrEdge> csrEdges(const CsrView& g);
+
+// Owning CSR graph. Memory and per-step matching cost grow with the number
+// of edges rather than with numVertices squared.
+class CsrGraph {
+public:
+    CsrGraph() = default;
+
+    static CsrGraph fromGraph(const Graph& g);
+    // Builds from a directed edge list; an undirected edge needs both
+    // directions. Throws std::invalid_argument on out-of-range vertices,
+    // zero weights or duplicate edges.
+    static CsrGraph fromEdges(int numVertices, std::vector<CsrEdge> edges);
+
+    Graph toGraph() const;
+
+    int numVertices() const { return n; }
+    bool symmetric() const { return isSymmetric; }
+    int weight(int from, int to) const;  // 0 when there is no edge
+
+    CsrView view() const;
+    operator CsrView() const { return view(); }
+
+private:
+    int n = 0;
+    bool isSymmetric = true;
+    std::vector<int> outStart, outAdj, outWeight;
+    std::vector<int> inStart, inAdj, inWeight;  // empty when symmetric
+    std::vector<int> loop;
+
+    void buildInArrays();
+};
+
+#endif // CSR_GRAPH_H
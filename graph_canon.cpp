@@ -0,0 +1,706 @@
+#include "graph_canon.h"
+#include "graph_internal.h"
+#include "iso_stats.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <numeric>
+
+bool operator==(const CanonicalEdge& a, const CanonicalEdge& b) {
+    return a.from == b.from && a.to == b.to && a.weight == b.weight;
+}
+
+bool operator<(const CanonicalEdge& a, const CanonicalEdge& b) {
+    if (a.from != b.from) return a.from < b.from;
+    if (a.to != b.to) return a.to < b.to;
+    return a.weight < b.weight;
+}
+
+bool operator==(const CanonicalHash& a, const CanonicalHash& b) {
+    return a.high == b.high && a.low == b.low;
+}
+
+bool operator!=(const CanonicalHash& a, const CanonicalHash& b) {
+    return !(a == b);
+}
+
+bool operator==(const CanonicalForm& a, const CanonicalForm& b) {
+    return a.hash == b.hash && a.numVertices == b.numVertices && a.edges == b.edges;
+}
+
+bool operator!=(const CanonicalForm& a, const CanonicalForm& b) {
+    return !(a == b);
+}
+
+namespace {
+
+// Below this size a canonical search is too short to be worth any threads.
+const int kParallelMinVertices = 64;
+
+// Ordered partition of the vertices. Cells carry ids that stay with them
+// while they shrink; the search only ever looks at a cell's positions,
+// which depend on the refinement alone, never on vertex ids. Every change
+// is recorded so that backtracking can undo it instead of copying.
+struct Partition {
+    std::vector<int> lab;        // vertices by position
+    std::vector<int> pos;        // pos[v] = position of v in lab
+    std::vector<int> cellOf;     // cellOf[p] = id of the cell holding position p
+    std::vector<int> cellStart;  // per cell id: first position
+    std::vector<int> cellEnd;    // per cell id: one past the last position
+    int numCells = 0;            // cell ids in use, 0 .. numCells - 1
+    // Ids of the cells that had more than one vertex when created; some
+    // may have shrunk to singletons since.
+    std::vector<int> nonSingleton;
+
+    // Cell `cell` covered [start, end) before cells idsBefore .. were split
+    // off it.
+    struct Split {
+        int cell, start, end, idsBefore;
+    };
+    std::vector<Split> trail;
+
+    bool discrete() const { return numCells == static_cast<int>(lab.size()); }
+    int cellSize(int c) const { return cellEnd[c] - cellStart[c]; }
+
+    // Undoes every split recorded after trail held `mark` entries. Vertex
+    // order inside the merged cells is not restored; nothing depends on it.
+    void undo(size_t mark) {
+        while (trail.size() > mark) {
+            const Split& s = trail.back();
+            for (int id = s.idsBefore; id < numCells; ++id)
+                for (int i = cellStart[id]; i < cellEnd[id]; ++i) cellOf[i] = s.cell;
+            while (!nonSingleton.empty() && nonSingleton.back() >= s.idsBefore) nonSingleton.pop_back();
+            numCells = s.idsBefore;
+            cellStart[s.cell] = s.start;
+            cellEnd[s.cell] = s.end;
+            trail.pop_back();
+        }
+    }
+};
+
+// Weighted color refinement. Every split is folded into a trace hash, the
+// node invariant the search uses to compare and prune subtrees.
+class Refiner {
+public:
+    explicit Refiner(const CsrView& g)
+        : g(g), value(g.numVertices, 0), touched(g.numVertices, 0), inQueue(g.numVertices, 0) {}
+
+    // The coarsest equitable partition finer than the given colors, cells
+    // ordered by color. `trace`, when given, receives the refinement trace.
+    Partition initialPartition(const std::vector<std::uint64_t>& color, std::uint64_t* trace = nullptr) {
+        int n = g.numVertices;
+        Partition p;
+        p.lab.resize(n);
+        std::iota(p.lab.begin(), p.lab.end(), 0);
+        std::sort(p.lab.begin(), p.lab.end(), [&](int a, int b) { return color[a] < color[b]; });
+        p.pos.resize(n);
+        p.cellOf.resize(n);
+        p.cellStart.assign(n, 0);
+        p.cellEnd.assign(n, 0);
+
+        std::vector<int> splitters;
+        for (int i = 0; i < n; ++i) {
+            p.pos[p.lab[i]] = i;
+            if (i == 0 || color[p.lab[i]] != color[p.lab[i - 1]]) {
+                splitters.push_back(p.numCells);
+                p.cellStart[p.numCells++] = i;
+            }
+            p.cellOf[i] = splitters.back();
+            p.cellEnd[splitters.back()] = i + 1;
+        }
+        for (int c : splitters)
+            if (p.cellSize(c) > 1) p.nonSingleton.push_back(c);
+        std::uint64_t refined = refine(p, splitters.data(), splitters.data() + splitters.size());
+        if (trace) *trace = refined;
+        p.trail.clear();  // the root is never undone
+        return p;
+    }
+
+    // Moves v into a singleton cell in front of its old cell and refines.
+    std::uint64_t individualize(Partition& p, int v) {
+        int c = p.cellOf[p.pos[v]];
+        int start = p.cellStart[c];
+        int u = p.lab[start];
+        p.lab[p.pos[v]] = u;
+        p.pos[u] = p.pos[v];
+        p.lab[start] = v;
+        p.pos[v] = start;
+
+        p.trail.push_back({c, start, p.cellEnd[c], p.numCells});
+        int single = p.numCells++;
+        p.cellStart[single] = start;
+        p.cellEnd[single] = start + 1;
+        p.cellOf[start] = single;
+        p.cellStart[c] = start + 1;
+
+        return hashCombine(start, refine(p, &single, &single + 1));
+    }
+
+    long long rounds = 0;  // splitter cells processed, under GRAPHISO_STATS
+
+private:
+    const CsrView& g;
+    std::vector<std::uint64_t> value;
+    std::vector<char> touched;
+    std::vector<char> inQueue;
+    std::vector<int> touchedList;
+    std::vector<int> queue;      // splitter cell ids, consumed from queueHead
+    std::vector<int> fragments, fragmentIds;  // scratch of splitCell
+
+    void touch(int w, std::uint64_t contribution) {
+        if (!touched[w]) {
+            touched[w] = 1;
+            touchedList.push_back(w);
+        }
+        value[w] += contribution;
+    }
+
+    std::uint64_t refine(Partition& p, const int* first, const int* last) {
+        std::uint64_t trace = 0;
+        queue.assign(first, last);
+        size_t queueHead = 0;
+        for (const int* s = first; s != last; ++s) inQueue[*s] = 1;
+
+        while (queueHead < queue.size() && !p.discrete()) {
+            int s = queue[queueHead++];
+            inQueue[s] = 0;
+            trace = hashCombine(trace, p.cellStart[s]);
+            GRAPHISO_STAT(++rounds);
+
+            // Each vertex collects a hashed sum over its edges into the
+            // splitter cell, so equal values mean equal weighted degrees.
+            for (int i = p.cellStart[s]; i < p.cellEnd[s]; ++i) {
+                int v = p.lab[i];
+                for (int k = g.outStart[v]; k < g.outStart[v + 1]; ++k)
+                    touch(g.outAdj[k], splitmix64(static_cast<std::uint64_t>(g.outWeight[k]) * 4 + 1));
+                if (g.symmetric) continue;
+                for (int k = g.inStart[v]; k < g.inStart[v + 1]; ++k)
+                    touch(g.inAdj[k], splitmix64(static_cast<std::uint64_t>(g.inWeight[k]) * 4 + 2));
+            }
+
+            // Touched vertices grouped by cell, cells in position order;
+            // singletons cannot split.
+            size_t kept = 0;
+            for (int w : touchedList) {
+                int c = p.cellOf[p.pos[w]];
+                if (p.cellSize(c) == 1) {
+                    value[w] = 0;
+                    touched[w] = 0;
+                    continue;
+                }
+                touchedList[kept++] = w;
+            }
+            touchedList.resize(kept);
+            std::sort(touchedList.begin(), touchedList.end(), [&](int a, int b) {
+                return p.cellStart[p.cellOf[p.pos[a]]] < p.cellStart[p.cellOf[p.pos[b]]];
+            });
+            for (size_t i = 0; i < touchedList.size();) {
+                int c = p.cellOf[p.pos[touchedList[i]]];
+                size_t j = i;
+                while (j < touchedList.size() && p.cellOf[p.pos[touchedList[j]]] == c) ++j;
+                trace = splitCell(p, c, touchedList.data() + i, touchedList.data() + j, trace);
+                i = j;
+            }
+
+            for (int w : touchedList) {
+                value[w] = 0;
+                touched[w] = 0;
+            }
+            touchedList.clear();
+        }
+        for (size_t i = queueHead; i < queue.size(); ++i) inQueue[queue[i]] = 0;
+        return hashCombine(trace, p.numCells);
+    }
+
+    // Splits cell c by value; [first, last) are its touched vertices.
+    // Untouched vertices have value 0 and stay at the front under the
+    // cell's id; only the touched ones move, so the work is proportional
+    // to them unless the whole cell was touched.
+    std::uint64_t splitCell(Partition& p, int c, const int* first, const int* last, std::uint64_t trace) {
+        int start = p.cellStart[c], end = p.cellEnd[c];
+        int count = static_cast<int>(last - first);
+        int sortFrom = start;
+        if (count < end - start) {
+            // Swap the touched vertices to the back of the cell.
+            int back = end;
+            for (const int* t = first; t != last; ++t) {
+                int w = *t, q = p.pos[w], b = --back, x = p.lab[b];
+                p.lab[b] = w;
+                p.pos[w] = b;
+                p.lab[q] = x;
+                p.pos[x] = q;
+            }
+            sortFrom = back;
+        }
+        std::sort(p.lab.begin() + sortFrom, p.lab.begin() + end,
+                  [&](int a, int b) { return value[a] < value[b]; });
+        for (int i = sortFrom; i < end; ++i) p.pos[p.lab[i]] = i;
+        if (value[p.lab[start]] == value[p.lab[end - 1]]) return trace;
+
+        fragments.clear();
+        fragments.push_back(start);
+        for (int i = std::max(sortFrom, start + 1); i < end; ++i) {
+            std::uint64_t previous = i - 1 < sortFrom ? 0 : value[p.lab[i - 1]];
+            if (value[p.lab[i]] != previous) fragments.push_back(i);
+        }
+
+        // The first fragment keeps the cell's id, the others get new ones.
+        p.trail.push_back({c, start, end, p.numCells});
+        std::vector<int>& ids = fragmentIds;
+        ids.assign(1, c);
+        for (size_t f = 1; f < fragments.size(); ++f) {
+            int id = p.numCells++;
+            int fEnd = f + 1 < fragments.size() ? fragments[f + 1] : end;
+            p.cellStart[id] = fragments[f];
+            p.cellEnd[id] = fEnd;
+            for (int i = fragments[f]; i < fEnd; ++i) p.cellOf[i] = id;
+            if (fEnd - fragments[f] > 1) p.nonSingleton.push_back(id);
+            ids.push_back(id);
+        }
+        p.cellEnd[c] = fragments.size() > 1 ? fragments[1] : end;
+
+        trace = hashCombine(trace, start);
+        for (int id : ids) {
+            trace = hashCombine(trace, p.cellSize(id));
+            trace = hashCombine(trace, value[p.lab[p.cellStart[id]]]);
+        }
+
+        // Hopcroft's rule: a cell already waiting covers all its fragments,
+        // otherwise every fragment but the largest one is queued.
+        int skip = -1;
+        if (!inQueue[c]) {
+            skip = ids[0];
+            for (int id : ids) {
+                if (p.cellSize(id) > p.cellSize(skip)) skip = id;
+            }
+        }
+        for (int id : ids) {
+            if (id == skip || inQueue[id]) continue;
+            inQueue[id] = 1;
+            queue.push_back(id);
+        }
+        return trace;
+    }
+};
+
+int compareTraces(const std::vector<std::uint64_t>& a, const std::vector<std::uint64_t>& b) {
+    size_t common = std::min(a.size(), b.size());
+    for (size_t i = 0; i < common; ++i) {
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+    }
+    if (a.size() == b.size()) return 0;
+    return a.size() < b.size() ? -1 : 1;
+}
+
+size_t commonPrefix(const std::vector<int>& a, const std::vector<int>& b) {
+    size_t k = 0;
+    while (k < a.size() && k < b.size() && a[k] == b[k]) ++k;
+    return k;
+}
+
+// Depth-first search over the individualization tree. The canonical leaf
+// is the greatest one by (trace sequence, certificate); a leaf matching the
+// first or the best leaf yields an automorphism.
+//
+// Orbit pruning follows nauty: it only happens on the first path, where
+// every automorphism found so far fixes the path's individualized vertices
+// (they were all found in the subtree below the current first-path node).
+// Their orbits are kept in one union-find that grows as generators come
+// in. All nodes share one partition that is refined on the way down and
+// undone on the way up, and leaves are compared by testing the mapping
+// between them for an automorphism, so a node costs about as much as its
+// refinement and a leaf O(n + m).
+//
+// With several threads, the children of a first-path node after the first
+// one become tasks on a pool. They lie off the first path, so each is an
+// independent search that only needs the first leaf and a snapshot of the
+// best one; their automorphisms and best leaves are merged back as they
+// finish, and later tasks skip children already known to be equivalent.
+// The canonical leaf is the greatest one whichever order the subtrees are
+// searched in, so the form does not depend on the thread count.
+class CanonicalSearch {
+public:
+    CanonicalSearch(const CsrView& g, const IsoOptions& options)
+        : g(g), options(options), refiner(g), orbits(g.numVertices), traceOrder(g.numVertices + 2, 0), cells(g.numVertices + 1),
+          gen(g.numVertices), edgeMark(g.numVertices, 0), edgeWeight(g.numVertices, 0) {
+        std::iota(orbits.begin(), orbits.end(), 0);
+    }
+
+    void run() {
+        p = refiner.initialPartition(vertexInvariants(g));
+        unsigned threads = resolveThreadCount(options.numThreads);
+        if (threads > 1 && g.numVertices >= kParallelMinVertices) {
+            pool = std::make_unique<WorkStealingPool>(threads);
+            workers.resize(threads);
+        }
+        search(0);
+    }
+
+    std::vector<int> bestLab;
+    // Shared with the snapshots workers take of the best leaf.
+    std::shared_ptr<const std::vector<CanonicalEdge>> bestCert;
+    std::vector<std::vector<int>> generators;
+
+    // Adds this search's counters to stats.
+    void addStats(IsoStats& stats) const {
+        stats.canonicalNodes += nodes;
+        stats.refinementRounds += refiner.rounds;
+        stats.prunedByAutomorphism += prunedByAutomorphism;
+        stats.prunedByTrace += prunedByTrace;
+        stats.automorphisms += static_cast<long long>(generators.size());
+        for (const std::unique_ptr<CanonicalSearch>& worker : workers) {
+            if (!worker) continue;
+            stats.canonicalNodes += worker->nodes;
+            stats.refinementRounds += worker->refiner.rounds;
+            stats.prunedByAutomorphism += worker->prunedByAutomorphism;
+            stats.prunedByTrace += worker->prunedByTrace;
+        }
+    }
+
+private:
+    const CsrView& g;
+    const IsoOptions& options;
+    Refiner refiner;
+    Partition p;
+
+    std::vector<int> path;              // individualized vertices
+    std::vector<std::uint64_t> trace;   // node invariants along path
+    bool haveLeaf = false;
+    std::vector<int> firstPath, bestPath;
+    std::vector<std::uint64_t> firstTrace, bestTrace;
+    std::vector<int> firstLab;
+    long backjump = -1;
+    long long nodes = 0, prunedByAutomorphism = 0, prunedByTrace = 0;
+
+    // Orbits of all generators found so far, rooted at their smallest vertex.
+    std::vector<int> orbits;
+    // Per depth: how the trace down to it compares with the best trace cut
+    // to the same length (see compareToBest), reset whenever the best leaf
+    // changes.
+    std::vector<signed char> traceOrder;
+    // Per depth: the vertices of the target cell still to branch on.
+    std::vector<std::vector<int>> cells;
+    // Scratch of isAutomorphism.
+    std::vector<int> gen;
+    std::vector<int> edgeMark, edgeWeight;
+    int edgeStamp = 0;
+
+    // Parallel search, on the main search only: one searcher per pool
+    // worker, reused across tasks. `shared` guards the generators, orbits
+    // and best leaf while tasks merge into them.
+    std::unique_ptr<WorkStealingPool> pool;
+    std::vector<std::unique_ptr<CanonicalSearch>> workers;
+    std::mutex shared;
+    std::exception_ptr taskError;
+    bool bestChanged = false;  // on a worker: its best leaf is its own
+
+    void search(size_t depth) {
+        GRAPHISO_STAT(++nodes);
+        if (options.progress) {
+            options.progress->nodes.fetch_add(1, std::memory_order_relaxed);
+            options.progress->depth.store(static_cast<int>(depth), std::memory_order_relaxed);
+        }
+        if (options.cancel && options.cancel->load(std::memory_order_relaxed)) throw IsoCancelled();
+        if (p.discrete()) {
+            leaf();
+            return;
+        }
+
+        // Nodes entered before the first leaf form the first path. There
+        // the cell is walked in vertex order, and a child is explored
+        // exactly when it is the smallest vertex of its orbit; any smaller
+        // one came first. Elsewhere the rest of the cell is only listed
+        // once the first child returns without a backjump.
+        bool onFirstPath = !haveLeaf;
+        int c = targetCell();
+        std::vector<int>& cell = cells[depth];
+        cell.clear();
+        if (onFirstPath) {
+            cell.assign(p.lab.begin() + p.cellStart[c], p.lab.begin() + p.cellEnd[c]);
+            std::sort(cell.begin(), cell.end());
+        } else {
+            cell.push_back(p.lab[p.cellStart[c]]);
+        }
+
+        size_t mark = p.trail.size();
+        for (size_t i = 0; i < cell.size(); ++i) {
+            int w = cell[i];
+            if (onFirstPath && findRoot(orbits, w) != w) {
+                GRAPHISO_STAT(++prunedByAutomorphism);
+                continue;
+            }
+            if (onFirstPath && pool && i > 0) {
+                searchInParallel(depth, cell, i);
+                return;
+            }
+
+            path.push_back(w);
+            trace.push_back(refiner.individualize(p, w));
+            if (compareToBest(depth) >= 0) search(depth + 1);
+            else GRAPHISO_STAT(++prunedByTrace);
+            path.pop_back();
+            trace.pop_back();
+            p.undo(mark);
+
+            if (backjump >= 0) {
+                if (backjump < static_cast<long>(depth)) return;
+                backjump = -1;
+            }
+            if (!onFirstPath && i == 0) {
+                for (int k = p.cellStart[c]; k < p.cellEnd[c]; ++k) {
+                    if (p.lab[k] != w) cell.push_back(p.lab[k]);
+                }
+            }
+        }
+    }
+
+    // Searches the children cell[first ..] of the first-path node at
+    // `depth` as tasks, then merges what they found.
+    void searchInParallel(size_t depth, const std::vector<int>& cell, size_t first) {
+        for (size_t i = first; i < cell.size(); ++i) {
+            int w = cell[i];
+            if (findRoot(orbits, w) != w) {
+                GRAPHISO_STAT(++prunedByAutomorphism);
+                continue;
+            }
+            pool->submit([this, depth, w](unsigned worker) {
+                {
+                    std::lock_guard<std::mutex> lock(shared);
+                    if (taskError) return;
+                    if (findRoot(orbits, w) != w) {
+                        GRAPHISO_STAT(++prunedByAutomorphism);
+                        return;
+                    }
+                }
+                try {
+                    std::unique_ptr<CanonicalSearch>& local = workers[worker];
+                    if (!local) local = std::make_unique<CanonicalSearch>(g, options);
+                    local->searchBranch(*this, depth, w);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(shared);
+                    if (!taskError) taskError = std::current_exception();
+                }
+            });
+        }
+        pool->wait();
+        if (taskError) std::rethrow_exception(taskError);
+        // Any new best leaf lies below this node, so the traces down to it
+        // agree with the best one.
+        std::fill(traceOrder.begin(), traceOrder.begin() + depth + 1, 0);
+    }
+
+    // On a worker: searches the child w of the parent's node at `depth`,
+    // then merges its automorphisms and best leaf into the parent.
+    void searchBranch(CanonicalSearch& parent, size_t depth, int w) {
+        {
+            std::lock_guard<std::mutex> lock(parent.shared);
+            if (!haveLeaf) {
+                haveLeaf = true;
+                firstPath = parent.firstPath;
+                firstTrace = parent.firstTrace;
+                firstLab = parent.firstLab;
+            }
+            bestPath = parent.bestPath;
+            bestTrace = parent.bestTrace;
+            bestLab = parent.bestLab;
+            bestCert = parent.bestCert;
+        }
+        p = parent.p;
+        path = parent.path;
+        trace = parent.trace;
+        generators.clear();
+        bestChanged = false;
+        backjump = -1;
+        for (size_t k = 0; k < depth; ++k) compareToBest(k);
+
+        path.push_back(w);
+        trace.push_back(refiner.individualize(p, w));
+        if (compareToBest(depth) >= 0) search(depth + 1);
+        else GRAPHISO_STAT(++prunedByTrace);
+
+        std::lock_guard<std::mutex> lock(parent.shared);
+        for (std::vector<int>& generator : generators) {
+            for (int v = 0; v < g.numVertices; ++v) {
+                int a = findRoot(parent.orbits, v), b = findRoot(parent.orbits, generator[v]);
+                if (a != b) parent.orbits[std::max(a, b)] = std::min(a, b);
+            }
+            parent.generators.push_back(std::move(generator));
+        }
+        if (!bestChanged) return;
+        int order = compareTraces(bestTrace, parent.bestTrace);
+        if (order > 0 || (order == 0 && *parent.bestCert < *bestCert)) {
+            parent.bestPath = std::move(bestPath);
+            parent.bestTrace = std::move(bestTrace);
+            parent.bestLab = std::move(bestLab);
+            parent.bestCert = std::move(bestCert);
+        }
+    }
+
+    // Compares the trace down to the child just entered below `depth` with
+    // the best trace cut to the same length, from the comparison one level
+    // up; records the result for the child's own children.
+    int compareToBest(size_t depth) {
+        int order = traceOrder[depth];
+        if (!haveLeaf) order = 1;
+        else if (order == 0 && depth < bestTrace.size() && trace[depth] != bestTrace[depth])
+            order = trace[depth] < bestTrace[depth] ? -1 : 1;
+        else if (order == 0 && depth >= bestTrace.size())
+            order = 1;
+        traceOrder[depth + 1] = static_cast<signed char>(order);
+        return order;
+    }
+
+    // First non-singleton cell of maximum size, the leftmost among equals.
+    int targetCell() const {
+        int best = -1;
+        for (int c : p.nonSingleton) {
+            int size = p.cellSize(c);
+            if (size < 2) continue;
+            if (best < 0 || size > p.cellSize(best) ||
+                (size == p.cellSize(best) && p.cellStart[c] < p.cellStart[best]))
+                best = c;
+        }
+        return best;
+    }
+
+    std::vector<CanonicalEdge> certificate() const {
+        std::vector<CanonicalEdge> edges;
+        edges.reserve(static_cast<size_t>(g.numEdges()) + g.numVertices);
+        for (int v = 0; v < g.numVertices; ++v) {
+            if (g.loop[v] != 0) edges.push_back({p.pos[v], p.pos[v], g.loop[v]});
+            for (int k = g.outStart[v]; k < g.outStart[v + 1]; ++k)
+                edges.push_back({p.pos[v], p.pos[g.outAdj[k]], g.outWeight[k]});
+        }
+        std::sort(edges.begin(), edges.end());
+        return edges;
+    }
+
+    // Whether mapping each vertex of this leaf onto the vertex at the same
+    // position of otherLab preserves every edge and weight; the same as the
+    // two leaves having equal certificates. Leaves the mapping in gen.
+    bool isAutomorphism(const std::vector<int>& otherLab) {
+        for (int i = 0; i < g.numVertices; ++i) gen[p.lab[i]] = otherLab[i];
+        for (int v = 0; v < g.numVertices; ++v) {
+            int image = gen[v];
+            if (g.loop[v] != g.loop[image] || g.outDegree(v) != g.outDegree(image)) return false;
+            ++edgeStamp;
+            for (int k = g.outStart[image]; k < g.outStart[image + 1]; ++k) {
+                edgeMark[g.outAdj[k]] = edgeStamp;
+                edgeWeight[g.outAdj[k]] = g.outWeight[k];
+            }
+            for (int k = g.outStart[v]; k < g.outStart[v + 1]; ++k) {
+                int u = gen[g.outAdj[k]];
+                if (edgeMark[u] != edgeStamp || edgeWeight[u] != g.outWeight[k]) return false;
+            }
+        }
+        return true;
+    }
+
+    void addAutomorphism() {
+        for (int v = 0; v < g.numVertices; ++v) {
+            int a = findRoot(orbits, v), b = findRoot(orbits, gen[v]);
+            if (a != b) orbits[std::max(a, b)] = std::min(a, b);
+        }
+        generators.push_back(gen);
+    }
+
+    void leaf() {
+        if (!haveLeaf) {
+            haveLeaf = true;
+            firstPath = bestPath = path;
+            firstTrace = bestTrace = trace;
+            firstLab = bestLab = p.lab;
+            bestCert = std::make_shared<const std::vector<CanonicalEdge>>(certificate());
+            std::fill(traceOrder.begin(), traceOrder.end(), 0);
+            return;
+        }
+
+        if (trace == firstTrace && isAutomorphism(firstLab)) {
+            addAutomorphism();
+            backjump = static_cast<long>(commonPrefix(path, firstPath));
+            return;
+        }
+
+        int order = compareTraces(trace, bestTrace);
+        if (order < 0) return;
+        if (order == 0 && isAutomorphism(bestLab)) {
+            addAutomorphism();
+            backjump = static_cast<long>(commonPrefix(path, bestPath));
+            return;
+        }
+        std::vector<CanonicalEdge> cert = certificate();
+        if (order > 0 || *bestCert < cert) {
+            bestPath = path;
+            bestTrace = trace;
+            bestLab = p.lab;
+            bestCert = std::make_shared<const std::vector<CanonicalEdge>>(std::move(cert));
+            bestChanged = true;
+            std::fill(traceOrder.begin(), traceOrder.begin() + path.size() + 1, 0);
+        }
+    }
+};
+
+CanonicalHash hashEdges(int n, const std::vector<CanonicalEdge>& edges) {
+    CanonicalHash h;
+    h.high = hashCombine(0x243f6a8885a308d3ULL, n);
+    h.low = hashCombine(0x13198a2e03707344ULL, n);
+    for (const CanonicalEdge& e : edges) {
+        std::uint64_t packed = hashCombine(hashCombine(e.from, e.to), static_cast<std::uint64_t>(e.weight));
+        h.high = hashCombine(h.high, packed);
+        h.low = hashCombine(h.low ^ 0xa4093822299f31d0ULL, packed);
+    }
+    return h;
+}
+
+} // namespace
+
+CanonicalForm canonicalForm(const CsrView& g) {
+    return canonicalForm(g, IsoOptions());
+}
+
+CanonicalForm canonicalForm(const CsrView& g, const IsoOptions& options) {
+    CanonicalForm form;
+    form.numVertices = g.numVertices;
+    if (g.numVertices > 0) {
+        CanonicalSearch search(g, options);
+        search.run();
+        if (options.stats) search.addStats(*options.stats);
+
+        form.labeling.resize(g.numVertices);
+        for (int i = 0; i < g.numVertices; ++i) form.labeling[search.bestLab[i]] = i;
+        form.edges = *search.bestCert;
+        form.generators = std::move(search.generators);
+    }
+    form.hash = hashEdges(form.numVertices, form.edges);
+    return form;
+}
+
+CanonicalForm canonicalForm(const Graph& g) {
+    return canonicalForm(CsrGraph::fromGraph(g));
+}
+
+std::vector<std::uint64_t> equitableColors(const CsrView& g, const std::vector<std::uint64_t>& color) {
+    std::vector<std::uint64_t> result(g.numVertices);
+    if (g.numVertices == 0) return result;
+    Refiner refiner(g);
+    std::uint64_t trace = 0;
+    Partition p = refiner.initialPartition(color, &trace);
+    for (int v = 0; v < g.numVertices; ++v) result[v] = hashCombine(trace, p.cellStart[p.cellOf[p.pos[v]]]);
+    return result;
+}
+
+std::vector<int> automorphismOrbits(int numVertices, const std::vector<std::vector<int>>& generators) {
+    std::vector<int> parent(numVertices);
+    std::iota(parent.begin(), parent.end(), 0);
+    for (const std::vector<int>& gen : generators) {
+        for (int v = 0; v < numVertices; ++v) {
+            int a = findRoot(parent, v), b = findRoot(parent, gen[v]);
+            if (a != b) parent[std::max(a, b)] = std::min(a, b);
+        }
+    }
+    std::vector<int> orbits(numVertices);
+    for (int v = 0; v < numVertices; ++v) orbits[v] = findRoot(parent, v);
+    return orbits;
+}
@@ -0,0 +1,67 @@
+#ifndef GRAPH_CANON_H
+#define GRAPH_CANON_H
+
+#include <cstdint>
+#include <vector>
+#include "graph_utils.h"
+
+// Edge of the canonically relabeled graph; self-loops have from == to.
+struct CanonicalEdge {
+    int from = 0;
+    int to = 0;
+    int weight = 0;
+};
+
+bool operator==(const CanonicalEdge& a, const CanonicalEdge& b);
+bool operator<(const CanonicalEdge& a, const CanonicalEdge& b);
+
+// 128-bit hash of a canonical form. Equal forms always hash equal, so
+// differing hashes prove two graphs are not isomorphic.
+struct CanonicalHash {
+    std::uint64_t high = 0;
+    std::uint64_t low = 0;
+};
+
+bool operator==(const CanonicalHash& a, const CanonicalHash& b);
+bool operator!=(const CanonicalHash& a, const CanonicalHash& b);
+
+// Canonical form of a graph: the same for every relabeling of it, and
+// different for any graph that is not isomorphic to it.
+struct CanonicalForm {
+    int numVertices = 0;
+    std::vector<int> labeling;          // labeling[v] = canonical index of vertex v
+    std::vector<CanonicalEdge> edges;   // relabeled edges, sorted
+    CanonicalHash hash;
+    // Generators of the automorphism group found by the search, each as
+    // gen[v] = image of v; together they generate the whole group.
+    std::vector<std::vector<int>> generators;
+};
+
+// Two graphs are isomorphic exactly when their canonical forms compare
+// equal. The hash is compared first, so unequal forms cost O(1).
+bool operator==(const CanonicalForm& a, const CanonicalForm& b);
+bool operator!=(const CanonicalForm& a, const CanonicalForm& b);
+
+// Computes the canonical form by individualization-refinement: weighted
+// color refinement, individualization of one vertex per search level, and
+// pruning by refinement traces and by the automorphisms found on the way.
+CanonicalForm canonicalForm(const Graph& g);
+CanonicalForm canonicalForm(const CsrView& g);
+// Reports search nodes to options.progress, adds its counters to
+// options.stats and throws IsoCancelled once options.cancel is set. With
+// options.numThreads above one the search tree is split over that many
+// threads; the form is the same on any number of them.
+CanonicalForm canonicalForm(const CsrView& g, const IsoOptions& options);
+
+// Color refinement of `color` to the coarsest equitable partition. Vertices
+// get the same result color exactly when they share a cell; cells are
+// numbered by position and the refinement trace is mixed in, so the colors
+// of isomorphic graphs correspond under every isomorphism and graphs whose
+// refinements differ get disjoint colors.
+std::vector<std::uint64_t> equitableColors(const CsrView& g, const std::vector<std::uint64_t>& color);
+
+// orbits[v] = smallest vertex in the orbit of v under the group the
+// generators generate.
+std::vector<int> automorphismOrbits(int numVertices, const std::vector<std::vector<int>>& generators);
+
+#endif // GRAPH_CANON_H
@@ -0,0 +1,320 @@
+#include "graph_corpus.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char kMagic[8] = {'G', 'I', 'S', 'O', 'C', 'O', 'R', 'P'};
+const std::uint32_t kByteOrderMark = 0x01020304u;
+const std::uint32_t kVersion = 1;
+
+// Per-graph flags of an index entry.
+const std::uint32_t kSymmetric = 1u << 0;
+const std::uint32_t kWeighted = 1u << 1;
+const std::uint32_t kLoops = 1u << 2;
+
+struct Header {
+    char magic[8];
+    std::uint32_t byteOrder;
+    std::uint32_t version;
+    std::uint64_t graphCount;
+    std::uint64_t indexOffset;
+    std::uint64_t onesOffset;
+    std::uint64_t zerosOffset;
+    std::int32_t maxEdges;
+    std::int32_t maxVertices;
+    char reserved[8];
+};
+static_assert(sizeof(Header) == 64, "corpus header must stay 64 bytes");
+
+struct IndexRecord {
+    std::uint64_t offset;
+    std::int32_t numVertices;
+    std::int32_t numEdges;
+    std::uint32_t flags;
+    std::uint32_t reserved;
+};
+static_assert(sizeof(IndexRecord) == 24, "corpus index records must stay 24 bytes");
+
+// Number of 32-bit values a graph's data block holds.
+std::uint64_t dataInts(const IndexRecord& r) {
+    std::uint64_t n = static_cast<std::uint64_t>(r.numVertices);
+    std::uint64_t m = static_cast<std::uint64_t>(r.numEdges);
+    bool weighted = r.flags & kWeighted;
+    std::uint64_t ints = (n + 1) + m + (weighted ? m : 0) + ((r.flags & kLoops) ? n : 0);
+    if (!(r.flags & kSymmetric)) ints += (n + 1) + m + (weighted ? m : 0);
+    return ints;
+}
+
+} // namespace
+
+GraphCorpus::GraphCorpus(const std::string& path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot open " + path + ".");
+    fileHandle = file;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        unmap();
+        throw std::runtime_error("Cannot read the size of " + path + ".");
+    }
+    length = static_cast<size_t>(fileSize.QuadPart);
+    if (length >= sizeof(Header)) {
+        mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle) base = static_cast<const unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        if (!base) {
+            unmap();
+            throw std::runtime_error("Cannot map " + path + ".");
+        }
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Cannot open " + path + ".");
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot read the size of " + path + ".");
+    }
+    length = static_cast<size_t>(st.st_size);
+    if (length >= sizeof(Header)) {
+        void* p = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map " + path + ".");
+        }
+        base = static_cast<const unsigned char*>(p);
+        // Views are read in no particular order.
+        ::madvise(p, length, MADV_RANDOM);
+    }
+    ::close(fd);  // the mapping keeps the file alive
+#endif
+
+    Header h;
+    if (length < sizeof(Header) || (std::memcpy(&h, base, sizeof h), std::memcmp(h.magic, kMagic, sizeof kMagic) != 0)) {
+        unmap();
+        throw std::runtime_error(path + " is not a graph corpus.");
+    }
+    if (h.byteOrder != kByteOrderMark || h.version != kVersion) {
+        unmap();
+        throw std::runtime_error(path + " was written with a different byte order or format version.");
+    }
+    std::uint64_t indexBytes = h.graphCount * sizeof(IndexRecord);
+    if (h.indexOffset % 8 != 0 || h.indexOffset > length || indexBytes > length - h.indexOffset ||
+        h.onesOffset % 4 != 0 || h.onesOffset + 4ull * static_cast<std::uint64_t>(h.maxEdges) > length ||
+        h.zerosOffset % 4 != 0 || h.zerosOffset + 4ull * static_cast<std::uint64_t>(h.maxVertices) > length) {
+        unmap();
+        throw std::runtime_error(path + " is truncated or corrupt.");
+    }
+
+    count = static_cast<size_t>(h.graphCount);
+    index = base + h.indexOffset;
+    ones = reinterpret_cast<const int*>(base + h.onesOffset);
+    zeros = reinterpret_cast<const int*>(base + h.zerosOffset);
+    maxEdges = h.maxEdges;
+    maxVertices = h.maxVertices;
+}
+
+GraphCorpus::~GraphCorpus() { unmap(); }
+
+GraphCorpus::GraphCorpus(GraphCorpus&& other) noexcept { *this = std::move(other); }
+
+GraphCorpus& GraphCorpus::operator=(GraphCorpus&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        base = std::exchange(other.base, nullptr);
+        length = std::exchange(other.length, 0);
+        count = std::exchange(other.count, 0);
+        index = std::exchange(other.index, nullptr);
+        ones = std::exchange(other.ones, nullptr);
+        zeros = std::exchange(other.zeros, nullptr);
+        maxEdges = std::exchange(other.maxEdges, 0);
+        maxVertices = std::exchange(other.maxVertices, 0);
+#ifdef _WIN32
+        fileHandle = std::exchange(other.fileHandle, nullptr);
+        mappingHandle = std::exchange(other.mappingHandle, nullptr);
+#endif
+    }
+    return *this;
+}
+
+void GraphCorpus::unmap() {
+#ifdef _WIN32
+    if (base) UnmapViewOfFile(base);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle) CloseHandle(fileHandle);
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    if (base) ::munmap(const_cast<unsigned char*>(base), length);
+#endif
+    base = nullptr;
+    length = 0;
+    count = 0;
+}
+
+CsrView GraphCorpus::view(size_t i) const {
+    if (i >= count) throw std::out_of_range("Corpus index out of range.");
+    IndexRecord r;
+    std::memcpy(&r, index + i * sizeof(IndexRecord), sizeof r);
+
+    bool weighted = r.flags & kWeighted;
+    bool loops = r.flags & kLoops;
+    if (r.numVertices < 0 || r.numEdges < 0 || r.offset % 4 != 0 || r.offset > length ||
+        dataInts(r) > (length - r.offset) / 4 || (!weighted && r.numEdges > maxEdges) ||
+        (!loops && r.numVertices > maxVertices))
+        throw std::runtime_error("Corpus record " + std::to_string(i) + " is corrupt.");
+
+    int n = r.numVertices;
+    int m = r.numEdges;
+    const int* p = reinterpret_cast<const int*>(base + r.offset);
+
+    CsrView v;
+    v.numVertices = n;
+    v.symmetric = r.flags & kSymmetric;
+    v.outStart = p;
+    p += n + 1;
+    v.outAdj = p;
+    p += m;
+    if (weighted) {
+        v.outWeight = p;
+        p += m;
+    } else {
+        v.outWeight = ones;
+    }
+    if (loops) {
+        v.loop = p;
+        p += n;
+    } else {
+        v.loop = zeros;
+    }
+    if (v.symmetric) {
+        v.inStart = v.outStart;
+        v.inAdj = v.outAdj;
+        v.inWeight = v.outWeight;
+    } else {
+        v.inStart = p;
+        p += n + 1;
+        v.inAdj = p;
+        p += m;
+        v.inWeight = weighted ? p : ones;
+    }
+    return v;
+}
+
+bool GraphCorpus::isCorpusFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof kMagic];
+    return in.read(magic, sizeof magic) && std::memcmp(magic, kMagic, sizeof kMagic) == 0;
+}
+
+GraphCorpusWriter::GraphCorpusWriter(const std::string& path)
+    : out(path, std::ios::binary | std::ios::trunc), path(path) {
+    if (!out) throw std::runtime_error("Cannot create " + path + ".");
+    // Placeholder; close() rewrites the header once the offsets are known.
+    Header h{};
+    writeBytes(&h, sizeof h);
+}
+
+GraphCorpusWriter::~GraphCorpusWriter() = default;
+
+void GraphCorpusWriter::add(const Graph& g) {
+    CsrGraph csr = CsrGraph::fromGraph(g);
+    add(csr.view());
+}
+
+void GraphCorpusWriter::add(const CsrView& g) {
+    if (closed) throw std::logic_error("Corpus writer is already closed.");
+    int n = g.numVertices;
+    int m = g.numEdges();
+    bool weighted = !std::all_of(g.outWeight, g.outWeight + m, [](int w) { return w == 1; });
+    bool loops = !std::all_of(g.loop, g.loop + n, [](int w) { return w == 0; });
+
+    Entry e;
+    e.offset = position;
+    e.numVertices = n;
+    e.numEdges = m;
+    e.flags = (g.symmetric ? kSymmetric : 0u) | (weighted ? kWeighted : 0u) | (loops ? kLoops : 0u);
+    entries.push_back(e);
+    if (!weighted) maxEdges = std::max(maxEdges, m);
+    if (!loops) maxVertices = std::max(maxVertices, n);
+
+    if (n == 0) {
+        int zero = 0;
+        writeInts(&zero, 1);
+        return;
+    }
+    writeInts(g.outStart, n + 1);
+    writeInts(g.outAdj, m);
+    if (weighted) writeInts(g.outWeight, m);
+    if (loops) writeInts(g.loop, n);
+    if (!g.symmetric) {
+        writeInts(g.inStart, n + 1);
+        writeInts(g.inAdj, m);
+        if (weighted) writeInts(g.inWeight, m);
+    }
+}
+
+void GraphCorpusWriter::close() {
+    if (closed) return;
+    closed = true;
+
+    Header h{};
+    std::memcpy(h.magic, kMagic, sizeof kMagic);
+    h.byteOrder = kByteOrderMark;
+    h.version = kVersion;
+    h.graphCount = entries.size();
+    h.maxEdges = maxEdges;
+    h.maxVertices = maxVertices;
+
+    h.onesOffset = position;
+    std::vector<int> block(std::max(maxEdges, maxVertices), 1);
+    writeInts(block.data(), maxEdges);
+    h.zerosOffset = position;
+    std::fill(block.begin(), block.end(), 0);
+    writeInts(block.data(), maxVertices);
+
+    if (position % 8 != 0) {
+        int pad = 0;
+        writeInts(&pad, 1);
+    }
+    h.indexOffset = position;
+    for (const Entry& e : entries) {
+        IndexRecord r{e.offset, e.numVertices, e.numEdges, e.flags, 0};
+        writeBytes(&r, sizeof r);
+    }
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&h), sizeof h);
+    out.close();
+    if (!out) throw std::runtime_error("Failed writing " + path + ".");
+}
+
+void GraphCorpusWriter::writeInts(const int* data, size_t count) {
+    static_assert(sizeof(int) == 4, "corpus arrays are 32-bit");
+    writeBytes(data, count * sizeof(int));
+}
+
+void GraphCorpusWriter::writeBytes(const void* data, size_t size) {
+    if (size == 0) return;
+    if (!out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size)))
+        throw std::runtime_error("Failed writing " + path + ".");
+    position += size;
+}
@@ -0,0 +1,111 @@
+#ifndef GRAPH_CORPUS_H
+#define GRAPH_CORPUS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "csr_graph.h"
+#include "graph_utils.h"
+
+// Binary container for many graphs, laid out so a memory-mapped file can be
+// read in place:
+//
+//   header  64 bytes: magic "GISOCORP", byte-order mark, version, graph
+//           count, offsets of the index and of the shared blocks
+//   data    per graph, 32-bit CSR arrays in CsrView order and the byte
+//           order of the writing machine:
+//           outStart[n + 1], outAdj[m], outWeight[m], loop[n], and for
+//           directed graphs inStart[n + 1], inAdj[m], inWeight[m]
+//   shared  a run of ones and a run of zeros; unweighted graphs and graphs
+//           without self-loops point their weight/loop arrays there
+//           instead of storing them
+//   index   24 bytes per graph: data offset, n, m and flags
+//
+// Opening a corpus maps the file and reads the header only, so startup does
+// not depend on the number of graphs.
+
+// Memory-mapped, read-only corpus. Views point into the mapping and stay
+// valid while the corpus is open. The file is trusted: view() checks that a
+// record lies inside the file but not that its arrays form a valid graph.
+class GraphCorpus {
+public:
+    GraphCorpus() = default;
+    // Throws std::runtime_error when the file cannot be mapped or is not a
+    // corpus written on a machine with the same byte order.
+    explicit GraphCorpus(const std::string& path);
+    ~GraphCorpus();
+
+    GraphCorpus(GraphCorpus&& other) noexcept;
+    GraphCorpus& operator=(GraphCorpus&& other) noexcept;
+    GraphCorpus(const GraphCorpus&) = delete;
+    GraphCorpus& operator=(const GraphCorpus&) = delete;
+
+    size_t size() const { return count; }
+    // Throws std::out_of_range for a bad index and std::runtime_error for a
+    // record that points outside the file.
+    CsrView view(size_t index) const;
+    CsrView operator[](size_t index) const { return view(index); }
+
+    // True when the file starts with the corpus magic.
+    static bool isCorpusFile(const std::string& path);
+
+private:
+    const unsigned char* base = nullptr;
+    size_t length = 0;
+    size_t count = 0;
+    const unsigned char* index = nullptr;
+    const int* ones = nullptr;
+    const int* zeros = nullptr;
+    int maxEdges = 0;
+    int maxVertices = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+
+    void unmap();
+};
+
+// Streams graphs into a new corpus file. The index is kept in memory and
+// written by close(); a writer destroyed without close() leaves no usable
+// corpus behind.
+class GraphCorpusWriter {
+public:
+    // Throws std::runtime_error when the file cannot be created.
+    explicit GraphCorpusWriter(const std::string& path);
+    ~GraphCorpusWriter();
+
+    GraphCorpusWriter(const GraphCorpusWriter&) = delete;
+    GraphCorpusWriter& operator=(const GraphCorpusWriter&) = delete;
+
+    void add(const Graph& g);
+    void add(const CsrView& g);
+    size_t size() const { return entries.size(); }
+
+    // Writes the shared blocks, the index and the header. Throws
+    // std::runtime_error on a write failure.
+    void close();
+
+private:
+    struct Entry {
+        std::uint64_t offset;
+        std::int32_t numVertices;
+        std::int32_t numEdges;
+        std::uint32_t flags;
+    };
+
+    std::ofstream out;
+    std::string path;
+    std::vector<Entry> entries;
+    std::uint64_t position = 0;
+    int maxEdges = 0;
+    int maxVertices = 0;
+    bool closed = false;
+
+    void writeInts(const int* data, size_t count);
+    void writeBytes(const void* data, size_t size);
+};
+
+#endif // GRAPH_CORPUS_H
@@ -0,0 +1,220 @@
+#include "graph_generators.h"
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+std::uint64_t pairKey(int u, int v) {
+    if (u > v) std::swap(u, v);
+    return (static_cast<std::uint64_t>(u) << 32) | static_cast<std::uint32_t>(v);
+}
+
+bool hasEdge(const CsrView& g, int u, int v) {
+    const int* first = g.outAdj + g.outStart[u];
+    const int* last = g.outAdj + g.outStart[u + 1];
+    return std::binary_search(first, last, v);
+}
+
+// Adds both directions of every undirected edge.
+CsrGraph undirectedGraph(int n, const std::vector<CsrEdge>& edges) {
+    std::vector<CsrEdge> both;
+    both.reserve(edges.size() * 2);
+    for (const CsrEdge& e : edges) {
+        both.push_back(e);
+        both.push_back({e.to, e.from, e.weight});
+    }
+    return CsrGraph::fromEdges(n, std::move(both));
+}
+
+} // namespace
+
+CsrGraph erdosRenyiGraph(int n, double averageDegree, std::mt19937_64& rng, int maxWeight) {
+    std::vector<CsrEdge> edges;
+    std::uniform_int_distribution<int> weight(1, std::max(1, maxWeight));
+    double p = n > 1 ? averageDegree / (n - 1) : 0.0;
+
+    if (p >= 1.0) {
+        for (int v = 1; v < n; ++v)
+            for (int w = 0; w < v; ++w) edges.push_back({v, w, weight(rng)});
+    } else if (p > 0.0) {
+        // Batagelj-Brandes: geometric skips over the pairs w < v, so the
+        // cost follows the number of edges rather than n^2.
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        double logq = std::log(1.0 - p);
+        long long v = 1, w = -1;
+        while (v < n) {
+            w += 1 + static_cast<long long>(std::floor(std::log(1.0 - unit(rng)) / logq));
+            while (w >= v && v < n) {
+                w -= v;
+                ++v;
+            }
+            if (v < n) edges.push_back({static_cast<int>(v), static_cast<int>(w), weight(rng)});
+        }
+    }
+    return undirectedGraph(n, edges);
+}
+
+CsrGraph randomRegularGraph(int n, int degree, std::mt19937_64& rng) {
+    if (degree < 0 || (degree > 0 && degree >= n) || (static_cast<long long>(n) * degree) % 2 != 0)
+        throw std::invalid_argument("No simple regular graph with these parameters.");
+
+    // Pairs random free stubs, redrawing pairs that would form a loop or a
+    // double edge and starting over when stuck.
+    while (true) {
+        std::vector<int> stubs;
+        stubs.reserve(static_cast<size_t>(n) * degree);
+        for (int v = 0; v < n; ++v)
+            for (int k = 0; k < degree; ++k) stubs.push_back(v);
+
+        std::unordered_set<std::uint64_t> seen;
+        std::vector<CsrEdge> edges;
+        bool stuck = false;
+        while (!stubs.empty() && !stuck) {
+            stuck = true;
+            for (int attempt = 0; attempt < 100; ++attempt) {
+                std::uniform_int_distribution<size_t> pick(0, stubs.size() - 1);
+                size_t i = pick(rng), j = pick(rng);
+                int u = stubs[i], v = stubs[j];
+                if (i == j || u == v || seen.count(pairKey(u, v))) continue;
+
+                seen.insert(pairKey(u, v));
+                edges.push_back({u, v, 1});
+                if (i < j) std::swap(i, j);
+                stubs[i] = stubs.back();
+                stubs.pop_back();
+                stubs[j] = stubs.back();
+                stubs.pop_back();
+                stuck = false;
+                break;
+            }
+        }
+        if (!stuck) return undirectedGraph(n, edges);
+    }
+}
+
+CsrGraph paleyGraph(int q) {
+    bool prime = q > 2;
+    for (int d = 2; prime && d * d <= q; ++d) prime = q % d != 0;
+    if (!prime || q % 4 != 1) throw std::invalid_argument("Paley graphs need a prime order q = 1 mod 4.");
+
+    std::vector<char> square(q, 0);
+    for (long long x = 1; x < q; ++x) square[x * x % q] = 1;
+
+    std::vector<CsrEdge> edges;
+    for (int v = 0; v < q; ++v)
+        for (int w = v + 1; w < q; ++w)
+            if (square[w - v]) edges.push_back({v, w, 1});
+    return undirectedGraph(q, edges);
+}
+
+CsrGraph cfiGraph(const CsrView& base, bool twisted) {
+    int n = base.numVertices;
+    std::vector<int> first(n);  // first gadget vertex of each base vertex
+    int total = 0;
+    for (int v = 0; v < n; ++v) {
+        int d = base.outDegree(v);
+        if (d > 16) throw std::invalid_argument("CFI base degree above 16.");
+        first[v] = total;
+        total += 2 * d + (1 << std::max(0, d - 1));
+    }
+
+    // Per base vertex v of degree d: end vertices a(k, b) = first + 2k + b for
+    // each incident edge k and bit b, then one middle vertex per even
+    // subset S of the incident edges, joined to a(k, [k in S]).
+    std::vector<CsrEdge> edges;
+    for (int v = 0; v < n; ++v) {
+        int d = base.outDegree(v);
+        int middle = first[v] + 2 * d;
+        for (int mask = 0; mask < (1 << d); ++mask) {
+            if (std::bitset<16>(mask).count() % 2 != 0) continue;
+            for (int k = 0; k < d; ++k) edges.push_back({middle, first[v] + 2 * k + ((mask >> k) & 1), 1});
+            ++middle;
+        }
+    }
+
+    // Each base edge joins the matching end vertices; a twist crosses them.
+    bool twistPending = twisted;
+    for (int u = 0; u < n; ++u) {
+        for (int k = base.outStart[u]; k < base.outStart[u + 1]; ++k) {
+            int v = base.outAdj[k];
+            if (v < u) continue;
+            int ku = k - base.outStart[u];
+            int kv = static_cast<int>(std::lower_bound(base.outAdj + base.outStart[v], base.outAdj + base.outStart[v + 1], u) -
+                                      (base.outAdj + base.outStart[v]));
+            int flip = twistPending ? 1 : 0;
+            twistPending = false;
+            for (int b = 0; b < 2; ++b) edges.push_back({first[u] + 2 * ku + b, first[v] + 2 * kv + (b ^ flip), 1});
+        }
+    }
+    return undirectedGraph(total, edges);
+}
+
+CsrGraph gridGraph(int rows, int cols, bool torus) {
+    std::vector<CsrEdge> edges;
+    std::unordered_set<std::uint64_t> seen;
+    auto add = [&](int a, int b) {
+        if (a != b && seen.insert(pairKey(a, b)).second) edges.push_back({a, b, 1});
+    };
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            int v = r * cols + c;
+            if (c + 1 < cols) add(v, v + 1);
+            else if (torus) add(v, r * cols);
+            if (r + 1 < rows) add(v, v + cols);
+            else if (torus) add(v, c);
+        }
+    }
+    return undirectedGraph(rows * cols, edges);
+}
+
+CsrGraph relabeledGraph(const CsrView& g, std::mt19937_64& rng) {
+    std::vector<int> perm(g.numVertices);
+    std::iota(perm.begin(), perm.end(), 0);
+    std::shuffle(perm.begin(), perm.end(), rng);
+
+    std::vector<CsrEdge> edges = csrEdges(g);
+    for (CsrEdge& e : edges) {
+        e.from = perm[e.from];
+        e.to = perm[e.to];
+    }
+    return CsrGraph::fromEdges(g.numVertices, std::move(edges));
+}
+
+CsrGraph nearMissGraph(const CsrView& g, std::mt19937_64& rng) {
+    int n = g.numVertices;
+    long long m = g.numEdges();
+    if (m == 0 || m == static_cast<long long>(n) * (n - 1))
+        throw std::invalid_argument("No edge to move.");
+
+    std::vector<CsrEdge> edges = csrEdges(g);
+    std::vector<size_t> movable;
+    for (size_t i = 0; i < edges.size(); ++i) {
+        const CsrEdge& e = edges[i];
+        if (e.from != e.to && (!g.symmetric || e.from < e.to)) movable.push_back(i);
+    }
+    CsrEdge moved = edges[movable[std::uniform_int_distribution<size_t>(0, movable.size() - 1)(rng)]];
+
+    std::uniform_int_distribution<int> vertex(0, n - 1);
+    int u, v;
+    do {
+        u = vertex(rng);
+        v = vertex(rng);
+    } while (u == v || hasEdge(g, u, v));
+
+    std::vector<CsrEdge> result;
+    result.reserve(edges.size());
+    for (const CsrEdge& e : edges) {
+        bool removed = (e.from == moved.from && e.to == moved.to) ||
+                       (g.symmetric && e.from == moved.to && e.to == moved.from);
+        if (!removed) result.push_back(e);
+    }
+    result.push_back({u, v, moved.weight});
+    if (g.symmetric) result.push_back({v, u, moved.weight});
+    return CsrGraph::fromEdges(n, std::move(result));
+}
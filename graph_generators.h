@@ -0,0 +1,38 @@
+#ifndef GRAPH_GENERATORS_H
+#define GRAPH_GENERATORS_H
+
+#include <random>
+#include "csr_graph.h"
+
+// Graph families for benchmarking. All graphs are undirected and without
+// self-loops; the random ones are reproducible for a given generator state.
+
+// G(n, p) with p chosen for the given average degree; edge weights are
+// uniform in [1, maxWeight].
+CsrGraph erdosRenyiGraph(int n, double averageDegree, std::mt19937_64& rng, int maxWeight = 1);
+
+// Uniform-ish random d-regular simple graph by pairing with rejection.
+// Throws std::invalid_argument when n * degree is odd or degree >= n.
+CsrGraph randomRegularGraph(int n, int degree, std::mt19937_64& rng);
+
+// Paley graph on the field of order q: a strongly regular graph, so every
+// vertex looks alike to degree and neighborhood invariants. Throws
+// std::invalid_argument unless q is a prime congruent to 1 mod 4.
+CsrGraph paleyGraph(int q);
+
+// Cai-Fürer-Immerman graph over a connected base graph. The twisted and
+// untwisted graphs over the same base are not isomorphic, yet color
+// refinement cannot tell them apart.
+CsrGraph cfiGraph(const CsrView& base, bool twisted);
+
+// rows x cols grid, wrapped into a torus on request.
+CsrGraph gridGraph(int rows, int cols, bool torus = false);
+
+// The same graph under a uniformly random vertex permutation.
+CsrGraph relabeledGraph(const CsrView& g, std::mt19937_64& rng);
+
+// Moves one random undirected edge, with its weight, to a random non-adjacent
+// pair. Throws std::invalid_argument when g has no edge or is complete.
+CsrGraph nearMissGraph(const CsrView& g, std::mt19937_64& rng);
+
+#endif // GRAPH_GENERATORS_H
@@ -0,0 +1,43 @@
+#ifndef GRAPH_INTERNAL_H
+#define GRAPH_INTERNAL_H
+
+// Helpers shared by the isomorphism sources; not part of the public API.
+
+#include <cstdint>
+#include <vector>
+#include "csr_graph.h"
+
+// Search counters for IsoStats. Building with GRAPHISO_STATS=0 compiles
+// every GRAPHISO_STAT statement out of the hot loops.
+#ifndef GRAPHISO_STATS
+#define GRAPHISO_STATS 1
+#endif
+#if GRAPHISO_STATS
+#define GRAPHISO_STAT(statement) statement
+#else
+#define GRAPHISO_STAT(statement) ((void)0)
+#endif
+
+// Per-vertex isomorphism invariant: degree signature folded with neighbor
+// signatures and the triangle count, as used by the pre-filter.
+std::vector<std::uint64_t> vertexInvariants(const CsrView& g);
+
+inline std::uint64_t splitmix64(std::uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Order dependent, so callers fold sorted sequences.
+inline std::uint64_t hashCombine(std::uint64_t h, std::uint64_t v) {
+    return splitmix64(h ^ splitmix64(v));
+}
+
+// Union-find lookup with path halving.
+inline int findRoot(std::vector<int>& parent, int v) {
+    while (parent[v] != v) v = parent[v] = parent[parent[v]];
+    return v;
+}
+
+#endif // GRAPH_INTERNAL_H
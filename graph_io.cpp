@@ -0,0 +1,33 @@
+#include "graph_io.h"
+#include <stdexcept>
+#include <string>
+
+bool readGraph(std::istream& in, Graph& g) {
+    int n;
+    if (!(in >> n)) {
+        if (in.eof()) return false;
+        throw std::runtime_error("Expected a vertex count.");
+    }
+    if (n < 0) throw std::runtime_error("Negative vertex count.");
+
+    g.numVertices = n;
+    g.adjacencyMatrix.assign(n, std::vector<int>(n, 0));
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            if (!(in >> g.adjacencyMatrix[i][j]))
+                throw std::runtime_error("Adjacency matrix ends early in row " + std::to_string(i + 1) + ".");
+        }
+    }
+    return true;
+}
+
+void writeGraph(std::ostream& out, const Graph& g) {
+    out << g.numVertices << '\n';
+    for (int i = 0; i < g.numVertices; ++i) {
+        for (int j = 0; j < g.numVertices; ++j) {
+            if (j > 0) out << ' ';
+            out << g.adjacencyMatrix[i][j];
+        }
+        out << '\n';
+    }
+}
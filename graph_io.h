@@ -0,0 +1,17 @@
+#ifndef GRAPH_IO_H
+#define GRAPH_IO_H
+
+#include <istream>
+#include <ostream>
+#include "graph_utils.h"
+
+// Text format used by g1.txt/g2.txt: the vertex count followed by the
+// adjacency matrix, one row per line. Graphs may follow each other in one
+// stream.
+
+// Reads the next graph. Returns false when the stream ends before a new
+// graph starts; throws std::runtime_error on malformed input.
+bool readGraph(std::istream& in, Graph& g);
+void writeGraph(std::ostream& out, const Graph& g);
+
+#endif // GRAPH_IO_H
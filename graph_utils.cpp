@@ -1,28 +1,469 @@
 #include "graph_utils.h"
+#include "adjacency_storage.h"
+#include "graph_canon.h"
+#include "graph_internal.h"
+#include "iso_stats.h"
+#include "matcher.h"
+#include "thread_pool.h"
 #include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <numeric>
+#include <thread>
+#include <tuple>
 
-// Function definition
-bool areGraphsIsomorphic(const Graph& g1, const Graph& g2) {
-    if (g1.numVertices != g2.numVertices) return false;
-
-    int n = g1.numVertices;
-    std::vector<int> perm(n);
-    for (int i = 0; i < n; ++i) perm[i] = i;
-
-    do {
-        bool match = true;
-        for (int i = 0; i < n; ++i) {
-            for (int j = 0; j < n; ++j) {
-                if (g1.adjacencyMatrix[i][j] != g2.adjacencyMatrix[perm[i]][perm[j]]) {
-                    match = false;
-                    break;
-                }
+namespace {
+
+// Vertex label used to restrict candidates: anything an isomorphism must
+// preserve and that is cheap to read off a single vertex.
+using VertexSignature = std::tuple<int, int, int, long long, long long>;
+
+VertexSignature vertexSignature(const CsrView& a, int v) {
+    long long outSum = 0, inSum = 0;
+    for (int k = a.outStart[v]; k < a.outStart[v + 1]; ++k) outSum += a.outWeight[k];
+    for (int k = a.inStart[v]; k < a.inStart[v + 1]; ++k) inSum += a.inWeight[k];
+    return {a.outDegree(v), a.inDegree(v), a.loop[v], outSum, inSum};
+}
+
+std::uint64_t hashSignature(const VertexSignature& s) {
+    std::uint64_t h = hashCombine(std::get<0>(s), std::get<1>(s));
+    h = hashCombine(h, static_cast<std::uint64_t>(std::get<2>(s)));
+    h = hashCombine(h, static_cast<std::uint64_t>(std::get<3>(s)));
+    return hashCombine(h, static_cast<std::uint64_t>(std::get<4>(s)));
+}
+
+template <typename T>
+bool sameMultiset(std::vector<T> a, std::vector<T> b) {
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    return a == b;
+}
+
+std::vector<int> sortedWeights(const CsrView& a) {
+    std::vector<int> weights(a.outWeight, a.outWeight + a.numEdges());
+    for (int v = 0; v < a.numVertices; ++v) {
+        if (a.loop[v] != 0) weights.push_back(a.loop[v]);
+    }
+    std::sort(weights.begin(), weights.end());
+    return weights;
+}
+
+// Folds each vertex's label with the sorted multiset of (direction, weight,
+// neighbor label) over its incident edges.
+std::vector<std::uint64_t> neighborLabels(const CsrView& a, const std::vector<std::uint64_t>& label) {
+    std::vector<std::uint64_t> result(a.numVertices);
+    std::vector<std::uint64_t> entries;
+    for (int v = 0; v < a.numVertices; ++v) {
+        entries.clear();
+        for (int k = a.outStart[v]; k < a.outStart[v + 1]; ++k)
+            entries.push_back(hashCombine(hashCombine(1, a.outWeight[k]), label[a.outAdj[k]]));
+        if (!a.symmetric) {
+            for (int k = a.inStart[v]; k < a.inStart[v + 1]; ++k)
+                entries.push_back(hashCombine(hashCombine(2, a.inWeight[k]), label[a.inAdj[k]]));
+        }
+        std::sort(entries.begin(), entries.end());
+        std::uint64_t h = label[v];
+        for (std::uint64_t e : entries) h = hashCombine(h, e);
+        result[v] = h;
+    }
+    return result;
+}
+
+// Triangles through each vertex of the underlying undirected simple graph.
+// Edges are oriented from lower to higher (degree, id) rank, which bounds
+// the work by O(m * sqrt(m)).
+std::vector<int> triangleCounts(const CsrView& a) {
+    int n = a.numVertices;
+
+    // Undirected neighbor lists; a symmetric graph already is one.
+    std::vector<int> start, adj;
+    const int* nbStart = a.outStart;
+    const int* nbAdj = a.outAdj;
+    if (!a.symmetric) {
+        start.assign(n + 1, 0);
+        for (int v = 0; v < n; ++v) {
+            std::vector<int> nb(a.outAdj + a.outStart[v], a.outAdj + a.outStart[v + 1]);
+            nb.insert(nb.end(), a.inAdj + a.inStart[v], a.inAdj + a.inStart[v + 1]);
+            std::sort(nb.begin(), nb.end());
+            nb.erase(std::unique(nb.begin(), nb.end()), nb.end());
+            adj.insert(adj.end(), nb.begin(), nb.end());
+            start[v + 1] = static_cast<int>(adj.size());
+        }
+        nbStart = start.data();
+        nbAdj = adj.data();
+    }
+
+    auto before = [&](int u, int v) {
+        int du = nbStart[u + 1] - nbStart[u], dv = nbStart[v + 1] - nbStart[v];
+        return du != dv ? du < dv : u < v;
+    };
+    std::vector<int> forwardStart(n + 1, 0), forward;
+    for (int v = 0; v < n; ++v) {
+        for (int k = nbStart[v]; k < nbStart[v + 1]; ++k) {
+            if (before(v, nbAdj[k])) forward.push_back(nbAdj[k]);
+        }
+        forwardStart[v + 1] = static_cast<int>(forward.size());
+    }
+
+    std::vector<int> count(n, 0);
+    std::vector<int> mark(n, -1);
+    for (int u = 0; u < n; ++u) {
+        for (int k = forwardStart[u]; k < forwardStart[u + 1]; ++k) mark[forward[k]] = u;
+        for (int k = forwardStart[u]; k < forwardStart[u + 1]; ++k) {
+            int v = forward[k];
+            for (int l = forwardStart[v]; l < forwardStart[v + 1]; ++l) {
+                if (mark[forward[l]] != u) continue;
+                ++count[u];
+                ++count[v];
+                ++count[forward[l]];
             }
-            if (!match) break;
         }
-        if (match) return true;
+    }
+    return count;
+}
+
+// Same counts from the dense bitset rows of a symmetric graph: each
+// neighbor w of v shares |N(v) & N(w)| triangles with v, minus the hits
+// caused by self-loops. Costs O(m * n / 64) popcount words.
+std::vector<int> triangleCounts(const AdjacencyStorage& s) {
+    int n = s.numVertices();
+    std::vector<int> count(n, 0);
+    for (int v = 0; v < n; ++v) {
+        int twice = 0;
+        for (int w = 0; w < n; ++w) {
+            if (w == v || !s.hasEdge(v, w)) continue;
+            twice += s.commonNeighbors(v, w) - s.hasEdge(v, v) - s.hasEdge(w, w);
+        }
+        count[v] = twice / 2;
+    }
+    return count;
+}
+
+// Mixes the size of each vertex's (weakly) connected component into its
+// label. Vertices can only map within components of equal size, and
+// without this the matcher grows a small component's mapping into a larger
+// one and has to backtrack out of it, component after component.
+void addComponentSizes(const CsrView& a, std::vector<std::uint64_t>& label) {
+    std::vector<int> parent(a.numVertices);
+    std::iota(parent.begin(), parent.end(), 0);
+    for (int v = 0; v < a.numVertices; ++v) {
+        for (int k = a.outStart[v]; k < a.outStart[v + 1]; ++k) {
+            int r1 = findRoot(parent, v), r2 = findRoot(parent, a.outAdj[k]);
+            if (r1 != r2) parent[r1] = r2;
+        }
+    }
+    std::vector<int> size(a.numVertices, 0);
+    for (int v = 0; v < a.numVertices; ++v) ++size[findRoot(parent, v)];
+    for (int v = 0; v < a.numVertices; ++v) label[v] = hashCombine(label[v], size[findRoot(parent, v)]);
+}
+
+// Runs the invariant stages in order of cost. When every stage agrees the
+// per-vertex labels are returned so the matcher can reuse them as colors.
+FilterStage runPrefilter(const CsrView& a1, const CsrView& a2,
+                         const AdjacencyStorage* s1, const AdjacencyStorage* s2,
+                         std::vector<std::uint64_t>& label1, std::vector<std::uint64_t>& label2) {
+    if (a1.numVertices != a2.numVertices) return FilterStage::VertexCount;
+    int n = a1.numVertices;
+
+    if (a1.symmetric != a2.symmetric || sortedWeights(a1) != sortedWeights(a2))
+        return FilterStage::EdgeWeights;
+
+    std::vector<VertexSignature> sig1(n), sig2(n);
+    for (int v = 0; v < n; ++v) {
+        sig1[v] = vertexSignature(a1, v);
+        sig2[v] = vertexSignature(a2, v);
+    }
+    if (!sameMultiset(sig1, sig2)) return FilterStage::VertexSignatures;
+
+    label1.resize(n);
+    label2.resize(n);
+    for (int v = 0; v < n; ++v) {
+        label1[v] = hashSignature(sig1[v]);
+        label2[v] = hashSignature(sig2[v]);
+    }
+    label1 = neighborLabels(a1, label1);
+    label2 = neighborLabels(a2, label2);
+    if (!sameMultiset(label1, label2)) return FilterStage::NeighborSignatures;
+
+    std::vector<int> tri1 = s1 && a1.symmetric ? triangleCounts(*s1) : triangleCounts(a1);
+    std::vector<int> tri2 = s2 && a2.symmetric ? triangleCounts(*s2) : triangleCounts(a2);
+    if (!sameMultiset(tri1, tri2)) return FilterStage::Triangles;
+    for (int v = 0; v < n; ++v) {
+        label1[v] = hashCombine(label1[v], tri1[v]);
+        label2[v] = hashCombine(label2[v], tri2[v]);
+    }
+    if (!sameMultiset(label1, label2)) return FilterStage::Triangles;
+
+    return FilterStage::Passed;
+}
+
+// Canonical forms of both graphs; with threads to spare they are built at
+// once, each search splitting its tree over half of the threads.
+void canonicalForms(const CsrView& g1, const CsrView& g2, const IsoOptions& options,
+                    CanonicalForm& form1, CanonicalForm& form2) {
+    unsigned threads = resolveThreadCount(options.numThreads);
+    if (threads <= 1) {
+        form1 = canonicalForm(g1, options);
+        form2 = canonicalForm(g2, options);
+        return;
+    }
+
+    // The helper counts into its own stats, merged after the join.
+    IsoStats helperStats;
+    IsoOptions mainOptions = options;
+    IsoOptions helperOptions = options;
+    mainOptions.numThreads = threads / 2;
+    helperOptions.numThreads = threads - threads / 2;
+    if (options.stats) helperOptions.stats = &helperStats;
+    std::exception_ptr helperError;
+    std::thread helper([&] {
+        try {
+            form2 = canonicalForm(g2, helperOptions);
+        } catch (...) {
+            helperError = std::current_exception();
+        }
+    });
+    try {
+        form1 = canonicalForm(g1, mainOptions);
+    } catch (...) {
+        helper.join();
+        throw;
+    }
+    helper.join();
+    if (helperError) std::rethrow_exception(helperError);
+    if (options.stats) {
+        options.stats->canonicalNodes += helperStats.canonicalNodes;
+        options.stats->refinementRounds += helperStats.refinementRounds;
+        options.stats->prunedByAutomorphism += helperStats.prunedByAutomorphism;
+        options.stats->prunedByTrace += helperStats.prunedByTrace;
+        options.stats->automorphisms += helperStats.automorphisms;
+    }
+}
+
+// g1 vertex -> g2 vertex through the canonical labelings of equal forms.
+std::vector<int> mappingFromForms(const CanonicalForm& form1, const CanonicalForm& form2) {
+    int n = form1.numVertices;
+    std::vector<int> byLabel(n), mapping(n);
+    for (int v = 0; v < n; ++v) byLabel[form2.labeling[v]] = v;
+    for (int v = 0; v < n; ++v) mapping[v] = byLabel[form1.labeling[v]];
+    return mapping;
+}
+
+// Carries automorphisms of g2 over to g1: v -> mapping^-1(gen(mapping(v))).
+std::vector<std::vector<int>> conjugateGenerators(const std::vector<std::vector<int>>& generators,
+                                                  const std::vector<int>& mapping) {
+    int n = static_cast<int>(mapping.size());
+    std::vector<int> inverse(n);
+    for (int v = 0; v < n; ++v) inverse[mapping[v]] = v;
+    std::vector<std::vector<int>> result;
+    result.reserve(generators.size());
+    for (const std::vector<int>& gen : generators) {
+        std::vector<int> conjugate(n);
+        for (int v = 0; v < n; ++v) conjugate[v] = inverse[gen[mapping[v]]];
+        result.push_back(std::move(conjugate));
+    }
+    return result;
+}
+
+// Times the phases of a check into the stats it was given, if any, and
+// records the total time and peak memory when the check ends.
+class PhaseClock {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit PhaseClock(IsoStats* stats) : stats(stats) {
+        if (!stats) return;
+        *stats = IsoStats();
+        start = last = Clock::now();
+    }
+
+    ~PhaseClock() {
+        if (!stats) return;
+        stats->totalSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        stats->peakMemoryBytes = peakResidentBytes();
+    }
+
+    PhaseClock(const PhaseClock&) = delete;
+    PhaseClock& operator=(const PhaseClock&) = delete;
+
+    // Charges the time since the previous lap to `phase`.
+    void lap(double IsoStats::*phase) {
+        if (!stats) return;
+        Clock::time_point now = Clock::now();
+        stats->*phase += std::chrono::duration<double>(now - last).count();
+        last = now;
+    }
+
+    void decided(IsoStats::Decider decider, FilterStage stage = FilterStage::Passed) {
+        if (!stats) return;
+        stats->decidedBy = decider;
+        stats->rejectedAt = stage;
+    }
+
+private:
+    IsoStats* stats;
+    Clock::time_point start, last;
+};
+
+// Everything after the cheap whole-graph comparisons: prefilter, matcher
+// and, when the matcher gives up, canonical forms. With automorphisms
+// requested, g2's group is computed first so the matcher can prune by it,
+// unless the refined colors are already discrete: the group is then
+// trivial and the matcher has no choices to prune.
+IsoMapping checkPair(const CsrView& g1, const CsrView& g2, const AdjacencyStorage* s1, const AdjacencyStorage* s2,
+                     const IsoOptions& options, PhaseClock& clock) {
+    IsoMapping result;
+    CanonicalForm form1, form2;
+    bool haveForm1 = false, haveForm2 = false;
+    bool trivialGroup = false;
+
+    // The group of g1, for isomorphic pairs only, comes from its own
+    // canonical form or from g2's generators carried over by the mapping;
+    // a trivial group has no generators.
+    auto finish = [&]() -> IsoMapping {
+        if (!result.isomorphic) result.mapping.clear();
+        if (!options.automorphisms || !result.isomorphic) return std::move(result);
+        if (haveForm1) {
+            result.generators = std::move(form1.generators);
+        } else if (haveForm2) {
+            result.generators = conjugateGenerators(form2.generators, result.mapping);
+        } else if (!trivialGroup) {
+            result.generators = canonicalForm(g1, options).generators;
+        }
+        result.orbits = automorphismOrbits(g1.numVertices, result.generators);
+        clock.lap(&IsoStats::canonicalSeconds);
+        return std::move(result);
+    };
+
+    std::vector<std::uint64_t> label1, label2;
+    FilterStage stage = runPrefilter(g1, g2, s1, s2, label1, label2);
+    clock.lap(&IsoStats::prefilterSeconds);
+    if (stage != FilterStage::Passed) {
+        clock.decided(IsoStats::Decider::Prefilter, stage);
+        return finish();
+    }
+
+    // Refining the labels to a stable coloring costs O(m log n) and leaves
+    // the matcher almost nothing to guess on graphs without much symmetry.
+    addComponentSizes(g1, label1);
+    addComponentSizes(g2, label2);
+    label1 = equitableColors(g1, label1);
+    label2 = equitableColors(g2, label2);
+    MatchPlan plan;
+    bool colorsAgree = plan.build(g1, g2, label1, label2, s2);
+    clock.lap(&IsoStats::planSeconds);
+    if (!colorsAgree) {
+        clock.decided(IsoStats::Decider::Matcher);
+        return finish();
+    }
+
+    // Automorphisms preserve the refined colors.
+    trivialGroup = static_cast<int>(plan.labelFreq.size()) == g2.numVertices;
+    if (options.automorphisms && !trivialGroup) {
+        form2 = canonicalForm(g2, options);
+        haveForm2 = true;
+        plan.symmetries2 = &form2.generators;
+        clock.lap(&IsoStats::canonicalSeconds);
+    }
+
+    MatchState::Outcome outcome = runMatcher(plan, options, &result.mapping);
+    clock.lap(&IsoStats::matchSeconds);
+    if (outcome == MatchState::Outcome::Cancelled) throw IsoCancelled();
+    if (outcome == MatchState::Outcome::OutOfBudget) {
+        if (haveForm2) form1 = canonicalForm(g1, options);
+        else canonicalForms(g1, g2, options, form1, form2);
+        haveForm1 = haveForm2 = true;
+        result.isomorphic = form1 == form2;
+        if (result.isomorphic) result.mapping = mappingFromForms(form1, form2);
+        clock.lap(&IsoStats::canonicalSeconds);
+        clock.decided(IsoStats::Decider::Canonical);
+    } else {
+        result.isomorphic = outcome == MatchState::Outcome::Found;
+        clock.decided(IsoStats::Decider::Matcher);
+    }
+    return finish();
+}
+
+} // namespace
+
+std::vector<std::uint64_t> vertexInvariants(const CsrView& a) {
+    std::vector<std::uint64_t> label(a.numVertices);
+    for (int v = 0; v < a.numVertices; ++v) label[v] = hashSignature(vertexSignature(a, v));
+    label = neighborLabels(a, label);
+    std::vector<int> tri = triangleCounts(a);
+    for (int v = 0; v < a.numVertices; ++v) label[v] = hashCombine(label[v], tri[v]);
+    return label;
+}
 
-    } while (std::next_permutation(perm.begin(), perm.end()));
+const char* filterStageName(FilterStage stage) {
+    switch (stage) {
+    case FilterStage::Passed: return "passed";
+    case FilterStage::VertexCount: return "vertex count";
+    case FilterStage::EdgeWeights: return "edge weights";
+    case FilterStage::VertexSignatures: return "vertex signatures";
+    case FilterStage::NeighborSignatures: return "neighbor signatures";
+    case FilterStage::Triangles: return "triangles";
+    }
+    return "unknown";
+}
+
+FilterStage prefilterGraphs(const Graph& g1, const Graph& g2) {
+    if (g1.numVertices != g2.numVertices) return FilterStage::VertexCount;
+
+    AdjacencyStorage s1(g1), s2(g2);
+    std::vector<std::uint64_t> label1, label2;
+    return runPrefilter(CsrGraph::fromGraph(g1), CsrGraph::fromGraph(g2), &s1, &s2, label1, label2);
+}
+
+FilterStage prefilterGraphs(const CsrView& g1, const CsrView& g2) {
+    std::vector<std::uint64_t> label1, label2;
+    return runPrefilter(g1, g2, nullptr, nullptr, label1, label2);
+}
+
+// Function definition
+bool areGraphsIsomorphic(const Graph& g1, const Graph& g2) {
+    return areGraphsIsomorphic(g1, g2, IsoOptions());
+}
+
+bool areGraphsIsomorphic(const Graph& g1, const Graph& g2, const IsoOptions& options) {
+    return findIsomorphism(g1, g2, options).isomorphic;
+}
+
+bool areGraphsIsomorphic(const CsrView& g1, const CsrView& g2) {
+    return areGraphsIsomorphic(g1, g2, IsoOptions());
+}
+
+bool areGraphsIsomorphic(const CsrView& g1, const CsrView& g2, const IsoOptions& options) {
+    return findIsomorphism(g1, g2, options).isomorphic;
+}
+
+IsoMapping findIsomorphism(const Graph& g1, const Graph& g2, const IsoOptions& options) {
+    PhaseClock clock(options.stats);
+    IsoMapping result;
+    if (g1.numVertices == g2.numVertices) {
+        AdjacencyStorage s1(g1), s2(g2);
+        if (!s1.sameMatrix(s2)) {
+            CsrGraph c1 = CsrGraph::fromGraph(g1);
+            CsrGraph c2 = CsrGraph::fromGraph(g2);
+            return checkPair(c1.view(), c2.view(), &s1, &s2, options, clock);
+        }
+        result.isomorphic = true;
+        result.mapping.resize(g1.numVertices);
+        for (int v = 0; v < g1.numVertices; ++v) result.mapping[v] = v;
+        clock.decided(IsoStats::Decider::Identical);
+        if (options.automorphisms) {
+            result.generators = canonicalForm(CsrGraph::fromGraph(g1), options).generators;
+            result.orbits = automorphismOrbits(g1.numVertices, result.generators);
+            clock.lap(&IsoStats::canonicalSeconds);
+        }
+    } else {
+        clock.decided(IsoStats::Decider::Prefilter, FilterStage::VertexCount);
+    }
+    return result;
+}
 
-    return false;
+IsoMapping findIsomorphism(const CsrView& g1, const CsrView& g2, const IsoOptions& options) {
+    PhaseClock clock(options.stats);
+    return checkPair(g1, g2, nullptr, nullptr, options, clock);
 }
@@ -1,7 +1,10 @@
 #ifndef GRAPH_UTILS_H
 #define GRAPH_UTILS_H
 
+#include <atomic>
+#include <stdexcept>
 #include <vector>
+#include "csr_graph.h"
 
 // Graph structure
 struct Graph {
@@ -9,7 +12,85 @@ struct Graph {
     std::vector<std::vector<int>> adjacencyMatrix;
 };
 
-// Function declaration for isomorphism check
+// Invariant checks run before any search, cheapest first. prefilterGraphs
+// reports the first stage at which the two graphs differ, or Passed when
+// only a search can decide.
+enum class FilterStage {
+    Passed,
+    VertexCount,         // number of vertices
+    EdgeWeights,         // multiset of edge and self-loop weights
+    VertexSignatures,    // (degree, weighted degree, self-loop) per vertex
+    NeighborSignatures,  // multiset of neighbor signatures per vertex
+    Triangles,           // triangles through each vertex
+};
+
+const char* filterStageName(FilterStage stage);
+FilterStage prefilterGraphs(const Graph& g1, const Graph& g2);
+FilterStage prefilterGraphs(const CsrView& g1, const CsrView& g2);
+
+// Live counters of a running check, safe to read from another thread.
+// nodes counts search tree nodes across all threads; depth is the depth of
+// the node most recently reported.
+struct IsoProgress {
+    std::atomic<long long> nodes{0};
+    std::atomic<int> depth{0};
+};
+
+// Thrown by a check whose cancel flag was raised.
+class IsoCancelled : public std::runtime_error {
+public:
+    IsoCancelled() : std::runtime_error("Isomorphism check cancelled.") {}
+};
+
+struct IsoStats;
+
+// Search settings. numThreads = 0 uses one thread per hardware thread;
+// inputs that are small or resolve quickly stay on the calling thread.
+// The search polls `cancel` and, once it is set, gives up by throwing
+// IsoCancelled; `progress`, when given, is updated as the search runs.
+// `stats` receives the search statistics of the check (see iso_stats.h).
+// With `automorphisms` set the automorphism group of the second graph is
+// computed up front and the matcher tries only one candidate per orbit.
+// That costs a canonical labeling of the second graph on every check whose
+// refined colors are not already discrete, and only pays off on small,
+// highly symmetric pairs; larger CFI pairs still need the canonical
+// fallback, which then reuses the labeling. findIsomorphism also reports
+// the group of the first graph when the graphs are isomorphic.
+struct IsoOptions {
+    unsigned numThreads = 1;
+    const std::atomic<bool>* cancel = nullptr;
+    IsoProgress* progress = nullptr;
+    IsoStats* stats = nullptr;
+    bool automorphisms = false;
+};
+
+// Result of findIsomorphism. mapping[v] is the vertex of g2 that vertex v
+// of g1 maps to, empty when the graphs are not isomorphic. With
+// IsoOptions::automorphisms and isomorphic graphs, generators generate the
+// automorphism group of g1 (gen[v] = image of v) and orbits[v] is the
+// smallest vertex of v's orbit under it; both stay empty otherwise.
+struct IsoMapping {
+    bool isomorphic = false;
+    std::vector<int> mapping;
+    std::vector<std::vector<int>> generators;
+    std::vector<int> orbits;
+};
+
+// Isomorphism check: exact match of every weight, self-loops included.
+// Runs a VF2++ style backtracking search, so only consistent partial
+// mappings are ever extended. With several threads the top levels of the
+// search are split into tasks and the first worker to find a mapping
+// stops the rest. Searches that exceed a step budget proportional to the
+// graph size are settled by comparing canonical forms instead. Throws
+// IsoCancelled when options.cancel is raised before the answer is known.
 bool areGraphsIsomorphic(const Graph& g1, const Graph& g2);
+bool areGraphsIsomorphic(const Graph& g1, const Graph& g2, const IsoOptions& options);
+// Same check straight on CSR data, for graphs too large for a matrix.
+bool areGraphsIsomorphic(const CsrView& g1, const CsrView& g2);
+bool areGraphsIsomorphic(const CsrView& g1, const CsrView& g2, const IsoOptions& options);
+
+// Same check, returning the isomorphism it found.
+IsoMapping findIsomorphism(const Graph& g1, const Graph& g2, const IsoOptions& options = IsoOptions());
+IsoMapping findIsomorphism(const CsrView& g1, const CsrView& g2, const IsoOptions& options = IsoOptions());
 
 #endif // GRAPH_UTILS_H
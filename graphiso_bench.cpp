@@ -0,0 +1,414 @@
+// Benchmark for areGraphsIsomorphic over generated graph families. Every
+// instance yields an isomorphic pair (a random relabeling) and a
+// non-isomorphic near miss; latency percentiles, throughput and peak memory
+// are reported per family and size, optionally against a stored baseline.
+// On POSIX systems every family and size runs in a child process of its
+// own, so the peak memory reported for it is its own.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "graph_generators.h"
+#include "graph_utils.h"
+#include "iso_stats.h"
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// One generated graph and a graph of the same size that is not isomorphic
+// to it.
+struct Instance {
+    CsrGraph graph;
+    CsrGraph nonIsomorphic;
+};
+
+struct Family {
+    std::string name;
+    std::string sizeMeaning;
+    std::vector<int> sizes;
+    std::function<Instance(int size, std::mt19937_64& rng)> make;
+};
+
+Instance withNearMiss(CsrGraph g, std::mt19937_64& rng) {
+    Instance inst;
+    inst.nonIsomorphic = nearMissGraph(g.view(), rng);
+    inst.graph = std::move(g);
+    return inst;
+}
+
+bool isConnected(const CsrView& g) {
+    if (g.numVertices == 0) return true;
+    std::vector<char> seen(g.numVertices, 0);
+    std::vector<int> stack = {0};
+    seen[0] = 1;
+    int count = 1;
+    while (!stack.empty()) {
+        int v = stack.back();
+        stack.pop_back();
+        for (int k = g.outStart[v]; k < g.outStart[v + 1]; ++k) {
+            int w = g.outAdj[k];
+            if (!seen[w]) {
+                seen[w] = 1;
+                ++count;
+                stack.push_back(w);
+            }
+        }
+    }
+    return count == g.numVertices;
+}
+
+std::vector<Family> allFamilies() {
+    std::vector<Family> families;
+    families.push_back({"er", "n", {100, 1000, 10000}, [](int n, std::mt19937_64& rng) {
+        return withNearMiss(erdosRenyiGraph(n, 8.0, rng), rng);
+    }});
+    families.push_back({"regular", "n", {100, 1000, 10000}, [](int n, std::mt19937_64& rng) {
+        return withNearMiss(randomRegularGraph(n, 4, rng), rng);
+    }});
+    families.push_back({"paley", "q", {29, 101, 197, 401}, [](int q, std::mt19937_64& rng) {
+        return withNearMiss(paleyGraph(q), rng);
+    }});
+    // The near miss is the twisted CFI graph over the same base: two edges
+    // differ, and no refinement-based invariant separates the pair.
+    families.push_back({"cfi", "base n", {4, 8, 12}, [](int k, std::mt19937_64& rng) {
+        CsrGraph base;
+        do {
+            base = randomRegularGraph(k, 3, rng);
+        } while (!isConnected(base.view()));
+        return Instance{cfiGraph(base.view(), false), cfiGraph(base.view(), true)};
+    }});
+    families.push_back({"grid", "side", {10, 32, 100}, [](int side, std::mt19937_64& rng) {
+        return withNearMiss(gridGraph(side, side), rng);
+    }});
+    families.push_back({"weighted", "n", {100, 1000, 10000}, [](int n, std::mt19937_64& rng) {
+        return withNearMiss(erdosRenyiGraph(n, 8.0, rng, 4), rng);
+    }});
+    // Graphs only CSR storage can hold; the largest has a million vertices
+    // and about three million edges.
+    families.push_back({"sparse", "n", {100000, 300000, 1000000}, [](int n, std::mt19937_64& rng) {
+        return withNearMiss(erdosRenyiGraph(n, 6.0, rng), rng);
+    }});
+    return families;
+}
+
+struct Row {
+    std::string family;
+    int size = 0;
+    std::string kind;  // "iso" or "near"
+    int numVertices = 0;
+    int numEdges = 0;   // undirected
+    int pairs = 0;
+    int wrong = 0;      // iso pairs rejected, or near misses accepted
+    double p50 = 0, p90 = 0, p99 = 0, max = 0;  // microseconds
+    double throughput = 0;                     // pairs per second
+    double peakRss = 0;                        // megabytes
+
+    std::string key() const { return family + " " + std::to_string(size) + " " + kind; }
+};
+
+double percentile(const std::vector<double>& sorted, double q) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(q * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+Row summarize(const std::string& family, int size, const std::string& kind, std::vector<double> micros, int wrong,
+              const CsrView& sample) {
+    Row r;
+    r.family = family;
+    r.size = size;
+    r.kind = kind;
+    r.numVertices = sample.numVertices;
+    r.numEdges = sample.numEdges() / 2;
+    r.pairs = static_cast<int>(micros.size());
+    r.wrong = wrong;
+    std::sort(micros.begin(), micros.end());
+    r.p50 = percentile(micros, 0.50);
+    r.p90 = percentile(micros, 0.90);
+    r.p99 = percentile(micros, 0.99);
+    r.max = micros.empty() ? 0.0 : micros.back();
+    double total = 0;
+    for (double t : micros) total += t;
+    r.throughput = total > 0 ? r.pairs * 1e6 / total : 0.0;
+    return r;
+}
+
+// Times `reps` instances of one family and size: the "iso" row for the
+// relabeled copies, the "near" row for the near misses. Both carry the
+// peak memory of the process that ran them.
+std::vector<Row> runSize(const Family& family, int size, int reps, unsigned long long seed, const IsoOptions& options) {
+    std::mt19937_64 rng(seed * 1000003ULL + std::hash<std::string>()(family.name) + size);
+
+    std::vector<double> isoTimes, nearTimes;
+    int isoWrong = 0, nearWrong = 0;
+    CsrGraph sample;
+    for (int rep = 0; rep < reps; ++rep) {
+        Instance inst = family.make(size, rng);
+        CsrGraph same = relabeledGraph(inst.graph.view(), rng);
+        CsrGraph near = relabeledGraph(inst.nonIsomorphic.view(), rng);
+
+        auto time = [&](const CsrGraph& other, std::vector<double>& out) {
+            auto start = std::chrono::steady_clock::now();
+            bool result = areGraphsIsomorphic(inst.graph.view(), other.view(), options);
+            auto end = std::chrono::steady_clock::now();
+            out.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+            return result;
+        };
+        if (!time(same, isoTimes)) ++isoWrong;
+        if (time(near, nearTimes)) ++nearWrong;
+        if (rep == 0) sample = std::move(inst.graph);
+    }
+
+    std::vector<Row> rows = {summarize(family.name, size, "iso", isoTimes, isoWrong, sample.view()),
+                             summarize(family.name, size, "near", nearTimes, nearWrong, sample.view())};
+    for (Row& r : rows) r.peakRss = peakResidentBytes() / (1024.0 * 1024.0);
+    return rows;
+}
+
+// One line per row with every measured field, for passing rows from the
+// child process back.
+std::string encodeRow(const Row& r) {
+    std::ostringstream out;
+    out.precision(17);
+    out << r.family << ' ' << r.size << ' ' << r.kind << ' ' << r.numVertices << ' ' << r.numEdges << ' ' << r.pairs
+        << ' ' << r.wrong << ' ' << r.p50 << ' ' << r.p90 << ' ' << r.p99 << ' ' << r.max << ' ' << r.throughput << ' '
+        << r.peakRss << '\n';
+    return out.str();
+}
+
+Row decodeRow(const std::string& line) {
+    std::istringstream in(line);
+    Row r;
+    if (!(in >> r.family >> r.size >> r.kind >> r.numVertices >> r.numEdges >> r.pairs >> r.wrong >> r.p50 >> r.p90 >>
+          r.p99 >> r.max >> r.throughput >> r.peakRss))
+        throw std::runtime_error("Malformed result from the benchmark child process.");
+    return r;
+}
+
+// runSize in a child process where fork is available, so that the peak
+// memory of one size is not inherited by the sizes after it.
+std::vector<Row> measureSize(const Family& family, int size, int reps, unsigned long long seed, const IsoOptions& options) {
+#ifdef _WIN32
+    return runSize(family, size, reps, seed, options);
+#else
+    int fds[2];
+    if (pipe(fds) != 0) throw std::runtime_error("Cannot create a pipe for the benchmark child process.");
+    std::fflush(stdout);
+    std::cout.flush();
+    pid_t child = fork();
+    if (child < 0) throw std::runtime_error("Cannot fork the benchmark child process.");
+    if (child == 0) {
+        close(fds[0]);
+        int status = 0;
+        try {
+            std::string text;
+            for (const Row& r : runSize(family, size, reps, seed, options)) text += encodeRow(r);
+            for (size_t done = 0; done < text.size();) {
+                ssize_t written = write(fds[1], text.data() + done, text.size() - done);
+                if (written <= 0) break;
+                done += static_cast<size_t>(written);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            status = 2;
+        }
+        close(fds[1]);
+        _exit(status);
+    }
+
+    close(fds[1]);
+    std::string text;
+    char buffer[4096];
+    ssize_t got;
+    while ((got = read(fds[0], buffer, sizeof buffer)) > 0) text.append(buffer, static_cast<size_t>(got));
+    close(fds[0]);
+    int status = 0;
+    waitpid(child, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        throw std::runtime_error("Benchmark child process for " + family.name + " " + std::to_string(size) + " failed.");
+
+    std::vector<Row> rows;
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) rows.push_back(decodeRow(line));
+    if (rows.size() != 2)
+        throw std::runtime_error("Benchmark child process for " + family.name + " " + std::to_string(size) + " failed.");
+    return rows;
+#endif
+}
+
+// Baseline files hold one row per line: family size kind p50 p90 p99
+// throughput, with '#' comment lines.
+std::map<std::string, Row> loadBaseline(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("Cannot open baseline " + path + ".");
+    std::map<std::string, Row> rows;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        Row r;
+        if (!(fields >> r.family >> r.size >> r.kind >> r.p50 >> r.p90 >> r.p99 >> r.throughput))
+            throw std::runtime_error("Malformed baseline line: " + line);
+        rows[r.key()] = r;
+    }
+    return rows;
+}
+
+void saveBaseline(const std::string& path, const std::vector<Row>& rows) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Cannot write baseline " + path + ".");
+    out << "# graphiso-bench baseline: family size kind p50_us p90_us p99_us pairs_per_s\n";
+    for (const Row& r : rows)
+        out << r.family << ' ' << r.size << ' ' << r.kind << ' ' << r.p50 << ' ' << r.p90 << ' ' << r.p99 << ' '
+            << r.throughput << '\n';
+}
+
+void printUsage() {
+    std::cout << "Usage: graphiso-bench [options]\n"
+                 "  --family NAME        run only this family (repeatable): er, regular,\n"
+                 "                       paley, cfi, grid, weighted, sparse\n"
+                 "  --quick              only the two smallest sizes of each family\n"
+                 "  --reps N             instances per family and size (default 10)\n"
+                 "  --seed S             generator seed (default 1)\n"
+                 "  -j, --threads N      threads per check (default 1, 0 = all)\n"
+                 "  --baseline FILE      compare the median latency with FILE\n"
+                 "  --save-baseline FILE write this run's results to FILE\n"
+                 "  --tolerance F        allowed median slowdown before a row counts as\n"
+                 "                       a regression (default 0.25 = 25%)\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::string> onlyFamilies;
+    bool quick = false;
+    int reps = 10;
+    unsigned long long seed = 1;
+    IsoOptions options;
+    std::string baselinePath, savePath;
+    double tolerance = 0.25;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " needs a value.\n";
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        } else if (arg == "--family") {
+            onlyFamilies.push_back(value());
+        } else if (arg == "--quick") {
+            quick = true;
+        } else if (arg == "--reps") {
+            reps = std::max(1, std::atoi(value().c_str()));
+        } else if (arg == "--seed") {
+            seed = std::strtoull(value().c_str(), nullptr, 10);
+        } else if (arg == "-j" || arg == "--threads") {
+            options.numThreads = static_cast<unsigned>(std::strtoul(value().c_str(), nullptr, 10));
+        } else if (arg == "--baseline") {
+            baselinePath = value();
+        } else if (arg == "--save-baseline") {
+            savePath = value();
+        } else if (arg == "--tolerance") {
+            tolerance = std::atof(value().c_str());
+        } else {
+            std::cerr << "Error: unknown option " << arg << ".\n";
+            return 2;
+        }
+    }
+
+    std::vector<Family> families = allFamilies();
+    for (const std::string& name : onlyFamilies) {
+        bool known = std::any_of(families.begin(), families.end(), [&](const Family& f) { return f.name == name; });
+        if (!known) {
+            std::cerr << "Error: unknown family " << name << ".\n";
+            return 2;
+        }
+    }
+
+    std::map<std::string, Row> baseline;
+    try {
+        if (!baselinePath.empty()) baseline = loadBaseline(baselinePath);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 2;
+    }
+
+    std::printf("%-9s %7s %5s %7s %8s %5s %10s %10s %10s %10s %11s %8s %s\n", "family", "size", "kind", "n", "m",
+                "pairs", "p50_us", "p90_us", "p99_us", "max_us", "pairs/s", "rss_MB", baseline.empty() ? "" : "vs baseline");
+
+    std::vector<Row> rows;
+    int regressions = 0, wrongAnswers = 0;
+    for (const Family& family : families) {
+        if (!onlyFamilies.empty() &&
+            std::find(onlyFamilies.begin(), onlyFamilies.end(), family.name) == onlyFamilies.end())
+            continue;
+        size_t numSizes = quick ? std::min<size_t>(2, family.sizes.size()) : family.sizes.size();
+        for (size_t s = 0; s < numSizes; ++s) {
+            int size = family.sizes[s];
+            std::vector<Row> measured;
+            try {
+                measured = measureSize(family, size, reps, seed, options);
+            } catch (const std::exception& e) {
+                std::cerr << "Error: " << e.what() << "\n";
+                return 2;
+            }
+            for (const Row& r : measured) {
+                std::string comparison;
+                auto it = baseline.find(r.key());
+                if (it != baseline.end() && it->second.p50 > 0) {
+                    double ratio = r.p50 / it->second.p50;
+                    char buf[64];
+                    std::snprintf(buf, sizeof buf, "x%.2f", ratio);
+                    comparison = buf;
+                    // Sub-microsecond medians are timer noise.
+                    if (ratio > 1.0 + tolerance && r.p50 - it->second.p50 > 1.0) {
+                        comparison += " REGRESSION";
+                        ++regressions;
+                    }
+                }
+                if (r.wrong > 0) comparison += " WRONG x" + std::to_string(r.wrong);
+                // A random near miss can happen to be isomorphic; only a
+                // rejected isomorphic pair is certainly a bug.
+                if (r.kind == "iso") wrongAnswers += r.wrong;
+
+                std::printf("%-9s %7d %5s %7d %8d %5d %10.1f %10.1f %10.1f %10.1f %11.1f %8.1f %s\n", r.family.c_str(),
+                            r.size, r.kind.c_str(), r.numVertices, r.numEdges, r.pairs, r.p50, r.p90, r.p99, r.max,
+                            r.throughput, r.peakRss, comparison.c_str());
+                std::fflush(stdout);
+                rows.push_back(r);
+            }
+        }
+    }
+
+    if (!savePath.empty()) {
+        try {
+            saveBaseline(savePath, rows);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 2;
+        }
+    }
+    if (wrongAnswers > 0) std::cerr << wrongAnswers << " isomorphic pairs were rejected.\n";
+    if (regressions > 0) std::cerr << regressions << " rows regressed against the baseline.\n";
+    return wrongAnswers > 0 || regressions > 0 ? 1 : 0;
+}
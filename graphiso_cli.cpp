@@ -0,0 +1,445 @@
+// Headless batch checker: reads graphs in the g1.txt text format or as
+// binary corpora (see graph_corpus.h) from files or stdin, checks
+// consecutive graphs as pairs on worker threads and prints one result line
+// per pair, in input order. With --classes it groups the graphs into
+// isomorphism classes instead. With --stats every pair's search
+// statistics go to stderr as JSON lines; with --mapping isomorphic pairs
+// list the vertex mapping. With --subgraph or --induced the first graph of
+// each pair is searched for inside the second instead.
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "graph_corpus.h"
+#include "graph_io.h"
+#include "graph_utils.h"
+#include "iso_class_index.h"
+#include "iso_stats.h"
+#include "subgraph_iso.h"
+#include "thread_pool.h"
+
+namespace {
+
+// A graph parsed from text, or a view into a memory-mapped corpus.
+struct InputGraph {
+    Graph graph;
+    CsrView view;
+    bool mapped = false;
+};
+
+struct PairJob {
+    size_t index = 0;
+    InputGraph first;
+    InputGraph second;
+};
+
+IsoMapping checkPair(const InputGraph& a, const InputGraph& b, IsoStats* stats) {
+    IsoOptions options;
+    options.stats = stats;
+    if (!a.mapped && !b.mapped) return findIsomorphism(a.graph, b.graph, options);
+    CsrGraph ownedA, ownedB;
+    if (!a.mapped) ownedA = CsrGraph::fromGraph(a.graph);
+    if (!b.mapped) ownedB = CsrGraph::fromGraph(b.graph);
+    return findIsomorphism(a.mapped ? a.view : ownedA.view(), b.mapped ? b.view : ownedB.view(), options);
+}
+
+// The subgraph matcher works on matrices, so mapped graphs are expanded.
+Graph denseGraph(const InputGraph& g) {
+    if (!g.mapped) return g.graph;
+    return CsrGraph::fromEdges(g.view.numVertices, csrEdges(g.view)).toGraph();
+}
+
+// Searches for the first graph of the pair inside the second.
+IsoMapping checkSubgraph(const InputGraph& pattern, const InputGraph& host, const SubgraphOptions& match) {
+    IsoMapping result;
+    result.isomorphic = findSubgraph(denseGraph(pattern), denseGraph(host), match, result.mapping);
+    return result;
+}
+
+// Bounded hand-off between the reader and the workers, so parsing never
+// runs arbitrarily far ahead of checking.
+class JobQueue {
+public:
+    explicit JobQueue(size_t capacity) : capacity(capacity) {}
+
+    void push(PairJob job) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return jobs.size() < capacity; });
+        jobs.push_back(std::move(job));
+        notEmpty.notify_one();
+    }
+
+    bool pop(PairJob& job) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return closed || !jobs.empty(); });
+        if (jobs.empty()) return false;
+        job = std::move(jobs.front());
+        jobs.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+private:
+    size_t capacity;
+    std::mutex mutex;
+    std::condition_variable notEmpty, notFull;
+    std::deque<PairJob> jobs;
+    bool closed = false;
+};
+
+// Collects results from the workers and prints them in pair order, along
+// with their statistics when there are any.
+class OrderedWriter {
+public:
+    // Subgraph results read "found" and "not-found" instead.
+    OrderedWriter(std::ostream& out, std::ostream& statsOut, bool subgraph)
+        : out(out), statsOut(statsOut), subgraph(subgraph) {}
+
+    void put(size_t index, bool isomorphic, std::vector<int> mapping, std::string statsJson) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready[index] = {isomorphic, std::move(mapping), std::move(statsJson)};
+        while (!ready.empty() && ready.begin()->first == next) {
+            const Result& r = ready.begin()->second;
+            if (subgraph)
+                out << next + 1 << (r.isomorphic ? " found" : " not-found");
+            else
+                out << next + 1 << (r.isomorphic ? " isomorphic" : " not-isomorphic");
+            for (int image : r.mapping) out << ' ' << image;
+            out << '\n';
+            if (!r.statsJson.empty()) statsOut << "{\"pair\":" << next + 1 << ",\"stats\":" << r.statsJson << "}\n";
+            ready.erase(ready.begin());
+            ++next;
+        }
+    }
+
+private:
+    struct Result {
+        bool isomorphic = false;
+        std::vector<int> mapping;
+        std::string statsJson;
+    };
+
+    std::ostream& out;
+    std::ostream& statsOut;
+    bool subgraph;
+    std::mutex mutex;
+    std::map<size_t, Result> ready;
+    size_t next = 0;
+};
+
+// Reads graphs from the inputs in turn, as if they were one stream. Corpus
+// files are mapped rather than parsed, and their views stay valid for the
+// reader's lifetime.
+class GraphReader {
+public:
+    explicit GraphReader(const std::vector<std::string>& paths) {
+        for (const std::string& path : paths) {
+            Input input;
+            input.name = path;
+            if (GraphCorpus::isCorpusFile(path)) {
+                input.corpus = std::make_unique<GraphCorpus>(path);
+            } else {
+                input.text = std::make_unique<std::ifstream>(path);
+                if (!*input.text) throw std::runtime_error("Cannot open " + path + ".");
+            }
+            inputs.push_back(std::move(input));
+        }
+    }
+
+    bool next(InputGraph& g) {
+        if (inputs.empty()) return readGraph(std::cin, g.graph);
+        while (current < inputs.size()) {
+            Input& input = inputs[current];
+            try {
+                if (input.corpus) {
+                    if (input.position < input.corpus->size()) {
+                        g.view = input.corpus->view(input.position++);
+                        g.mapped = true;
+                        return true;
+                    }
+                } else if (readGraph(*input.text, g.graph)) {
+                    return true;
+                }
+            } catch (const std::runtime_error& e) {
+                throw std::runtime_error(input.name + ": " + e.what());
+            }
+            ++current;
+        }
+        return false;
+    }
+
+private:
+    struct Input {
+        std::string name;
+        std::unique_ptr<std::ifstream> text;
+        std::unique_ptr<GraphCorpus> corpus;
+        size_t position = 0;
+    };
+
+    std::vector<Input> inputs;
+    size_t current = 0;
+};
+
+// Pair mode: graphs 2k and 2k + 1 form pair k. With `subgraph` set the
+// first graph of a pair is the pattern and the second the host.
+int checkPairs(const std::vector<std::string>& paths, unsigned threads, bool withStats, bool withMapping,
+               const SubgraphOptions* subgraph) {
+    JobQueue queue(threads * 4);
+    OrderedWriter writer(std::cout, std::cerr, subgraph != nullptr);
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            PairJob job;
+            while (queue.pop(job)) {
+                if (subgraph) {
+                    IsoMapping result = checkSubgraph(job.first, job.second, *subgraph);
+                    if (!withMapping) result.mapping.clear();
+                    writer.put(job.index, result.isomorphic, std::move(result.mapping), std::string());
+                    continue;
+                }
+                IsoStats stats;
+                IsoMapping result = checkPair(job.first, job.second, withStats ? &stats : nullptr);
+                if (!withMapping) result.mapping.clear();
+                writer.put(job.index, result.isomorphic, std::move(result.mapping),
+                           withStats ? isoStatsJson(stats) : std::string());
+            }
+        });
+    }
+
+    // Outlives the workers, which may still hold views into mapped corpora.
+    std::unique_ptr<GraphReader> reader;
+    int status = 0;
+    try {
+        reader = std::make_unique<GraphReader>(paths);
+        for (size_t index = 0;; ++index) {
+            PairJob job;
+            job.index = index;
+            if (!reader->next(job.first)) break;
+            if (!reader->next(job.second)) throw std::runtime_error("Odd number of graphs; the last one has no partner.");
+            queue.push(std::move(job));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        status = 1;
+    }
+
+    queue.close();
+    for (std::thread& t : workers) t.join();
+    return status;
+}
+
+const char* fingerprintName(IsoClassIndex::Fingerprint fingerprint) {
+    return fingerprint == IsoClassIndex::Fingerprint::Invariants ? "invariant" : "canonical";
+}
+
+// Class mode: every graph is assigned an isomorphism class, optionally
+// continuing from (and updating) a saved index, which must use the same
+// fingerprint mode.
+int assignClasses(const std::vector<std::string>& paths, unsigned threads, const std::string& indexPath,
+                  IsoClassIndex::Fingerprint fingerprint) {
+    const size_t kBatchSize = 4096;
+    try {
+        IsoClassIndex index(fingerprint);
+        if (!indexPath.empty() && std::ifstream(indexPath)) {
+            index = IsoClassIndex::load(indexPath);
+            if (index.fingerprint() != fingerprint)
+                throw std::runtime_error(indexPath + " holds " + fingerprintName(index.fingerprint()) +
+                                         " fingerprints, not " + fingerprintName(fingerprint) + " ones; " +
+                                         (fingerprint == IsoClassIndex::Fingerprint::Invariants ? "drop" : "add") +
+                                         " --invariants to continue it.");
+        }
+        size_t knownClasses = index.numClasses();
+
+        GraphReader reader(paths);
+        IsoOptions options;
+        options.numThreads = threads;
+        size_t graphNumber = 0;
+        bool more = true;
+        while (more) {
+            std::vector<CsrGraph> owned;
+            std::vector<CsrView> batch;
+            owned.reserve(kBatchSize);
+            InputGraph g;
+            while (batch.size() < kBatchSize && (more = reader.next(g))) {
+                if (g.mapped) {
+                    batch.push_back(g.view);
+                } else {
+                    owned.push_back(CsrGraph::fromGraph(g.graph));
+                    batch.push_back(owned.back().view());
+                }
+            }
+            for (int id : index.insertBatch(batch, options)) std::cout << ++graphNumber << ' ' << id << '\n';
+        }
+
+        if (!indexPath.empty()) index.save(indexPath);
+        std::cerr << graphNumber << " graphs, " << index.numClasses() - knownClasses << " new classes, "
+                  << index.numClasses() << " classes in total.\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Parses a thread count: plain digits, 0 for all hardware threads, and no
+// more than kMaxThreads.
+bool parseThreads(const char* text, unsigned& threads) {
+    const unsigned long kMaxThreads = 4096;
+    if (*text < '0' || *text > '9') return false;
+    char* end = nullptr;
+    errno = 0;
+    unsigned long value = std::strtoul(text, &end, 10);
+    if (*end != '\0' || errno == ERANGE || value > kMaxThreads) return false;
+    threads = static_cast<unsigned>(value);
+    return true;
+}
+
+void printUsage() {
+    std::cout << "Usage: graphiso-cli [-j threads] [--stats] [--mapping] [--classes [--index file] [--invariants]]\n"
+                 "                    [--subgraph | --induced [--at-least]] [file ...]\n"
+                 "Reads graphs (vertex count, then matrix rows) from the files in order,\n"
+                 "or stdin. Files written by graphiso-pack are memory-mapped instead of\n"
+                 "parsed.\n"
+                 "By default consecutive graphs are checked as pairs, printing\n"
+                 "  <pair number> isomorphic|not-isomorphic\n"
+                 "With --classes every graph is assigned an isomorphism class, printing\n"
+                 "  <graph number> <class id>\n"
+                 "With --subgraph or --induced the first graph of each pair is looked\n"
+                 "for inside the second, printing\n"
+                 "  <pair number> found|not-found\n"
+                 "  -j, --threads N   worker threads (default: all hardware threads)\n"
+                 "  --mapping         after \"isomorphic\" or \"found\", list the image in the\n"
+                 "                    second graph of every vertex of the first, from 0\n"
+                 "  --stats           write each pair's search statistics to stderr as\n"
+                 "                    one JSON object per line (isomorphism pairs only)\n"
+                 "  --index FILE      continue the class numbering saved in FILE and\n"
+                 "                    save the updated index back (implies --classes)\n"
+                 "  --invariants      fingerprint by vertex invariants instead of the\n"
+                 "                    canonical hash; must match the mode of an --index\n"
+                 "                    file that already exists\n"
+                 "  --subgraph        pattern edges must land on host edges\n"
+                 "  --induced         pattern non-edges must also land on non-edges\n"
+                 "  --at-least        host weights need only reach the pattern weights\n"
+                 "                    (implies --subgraph unless --induced is given)\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::ios::sync_with_stdio(false);
+
+    unsigned requestedThreads = 0;
+    bool classes = false;
+    bool withStats = false;
+    bool withMapping = false;
+    bool subgraph = false;
+    SubgraphOptions match;
+    std::string indexPath;
+    IsoClassIndex::Fingerprint fingerprint = IsoClassIndex::Fingerprint::Canonical;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        }
+        if (arg == "-j" || arg == "--threads") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " needs a value.\n";
+                return 2;
+            }
+            if (!parseThreads(argv[++i], requestedThreads)) {
+                std::cerr << "Error: bad thread count " << argv[i] << ".\n";
+                return 2;
+            }
+            continue;
+        }
+        if (arg == "--classes") {
+            classes = true;
+            continue;
+        }
+        if (arg == "--mapping") {
+            withMapping = true;
+            continue;
+        }
+        if (arg == "--stats") {
+            withStats = true;
+            continue;
+        }
+        if (arg == "--subgraph") {
+            subgraph = true;
+            continue;
+        }
+        if (arg == "--induced") {
+            subgraph = true;
+            match.mode = SubgraphOptions::Mode::Induced;
+            continue;
+        }
+        if (arg == "--at-least") {
+            subgraph = true;
+            match.weights = SubgraphOptions::Weights::AtLeast;
+            continue;
+        }
+        if (arg == "--invariants") {
+            fingerprint = IsoClassIndex::Fingerprint::Invariants;
+            continue;
+        }
+        if (arg == "--index") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " needs a value.\n";
+                return 2;
+            }
+            indexPath = argv[++i];
+            classes = true;
+            continue;
+        }
+        if (arg.size() > 2 && arg.compare(0, 2, "-j") == 0) {
+            if (!parseThreads(arg.c_str() + 2, requestedThreads)) {
+                std::cerr << "Error: bad thread count " << arg.substr(2) << ".\n";
+                return 2;
+            }
+            continue;
+        }
+        if (arg.size() > 1 && arg[0] == '-') {
+            std::cerr << "Error: unknown option " << arg << ".\n";
+            printUsage();
+            return 2;
+        }
+        paths.push_back(arg);
+    }
+    if (classes && (subgraph || withStats || withMapping)) {
+        std::cerr << "Error: --classes cannot be combined with pair options.\n";
+        return 2;
+    }
+    if (!classes && fingerprint == IsoClassIndex::Fingerprint::Invariants) {
+        std::cerr << "Error: --invariants needs --classes or --index.\n";
+        return 2;
+    }
+    if (subgraph && withStats) {
+        std::cerr << "Error: --stats is not available with --subgraph, --induced or --at-least.\n";
+        return 2;
+    }
+
+    unsigned threads = resolveThreadCount(requestedThreads);
+    int status = classes ? assignClasses(paths, threads, indexPath, fingerprint)
+                         : checkPairs(paths, threads, withStats, withMapping, subgraph ? &match : nullptr);
+    std::cout.flush();
+    return status;
+}
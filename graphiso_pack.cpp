@@ -0,0 +1,51 @@
+// Converts graphs from the g1.txt text format into a binary corpus (see
+// graph_corpus.h) that graphiso-cli and GraphCorpus can map directly.
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "graph_corpus.h"
+#include "graph_io.h"
+
+namespace {
+
+void packStream(std::istream& in, const std::string& name, GraphCorpusWriter& writer) {
+    Graph g;
+    try {
+        while (readGraph(in, g)) writer.add(g);
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error(name + ": " + e.what());
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if (args.empty() || args[0] == "-h" || args[0] == "--help") {
+        std::cout << "Usage: graphiso-pack output [file ...]\n"
+                     "Packs every graph from the text files, or stdin, into a corpus.\n";
+        return args.empty() ? 2 : 0;
+    }
+
+    try {
+        GraphCorpusWriter writer(args[0]);
+        if (args.size() == 1) {
+            packStream(std::cin, "stdin", writer);
+        } else {
+            for (size_t i = 1; i < args.size(); ++i) {
+                std::ifstream in(args[i]);
+                if (!in) throw std::runtime_error("Cannot open " + args[i] + ".");
+                packStream(in, args[i], writer);
+            }
+        }
+        writer.close();
+        std::cerr << "Packed " << writer.size() << " graphs into " << args[0] << ".\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
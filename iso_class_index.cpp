@@ -0,0 +1,214 @@
+#include "iso_class_index.h"
+#include "graph_canon.h"
+#include "graph_internal.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+const char kMagic[8] = {'G', 'I', 'S', 'O', 'I', 'D', 'X', '1'};
+const std::uint32_t kByteOrderMark = 0x01020304u;
+const std::uint32_t kVersion = 1;
+
+// Exact equality of two CSR graphs, labels included. The in-arrays follow
+// from the out-arrays, so they need no comparing.
+bool sameLabeledGraph(const CsrView& a, const CsrView& b) {
+    int n = a.numVertices;
+    if (n != b.numVertices || a.symmetric != b.symmetric) return false;
+    if (n == 0) return true;
+    int m = a.numEdges();
+    return std::equal(a.outStart, a.outStart + n + 1, b.outStart) &&
+           std::equal(a.outAdj, a.outAdj + m, b.outAdj) &&
+           std::equal(a.outWeight, a.outWeight + m, b.outWeight) &&
+           std::equal(a.loop, a.loop + n, b.loop);
+}
+
+template <typename T>
+void writeValue(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof value);
+}
+
+template <typename T>
+T readValue(std::istream& in) {
+    T value;
+    if (!in.read(reinterpret_cast<char*>(&value), sizeof value)) throw std::runtime_error("Index file is truncated.");
+    return value;
+}
+
+} // namespace
+
+IsoClassIndex::IsoClassIndex(Fingerprint mode) : mode(mode) {}
+
+IsoClassIndex::Prepared IsoClassIndex::prepare(const CsrView& g) const {
+    Prepared p;
+    if (mode == Fingerprint::Canonical) {
+        CanonicalForm form = canonicalForm(g);
+        p.key.high = form.hash.high;
+        p.key.low = form.hash.low;
+        std::vector<CsrEdge> edges;
+        edges.reserve(form.edges.size());
+        for (const CanonicalEdge& e : form.edges) edges.push_back({e.from, e.to, e.weight});
+        p.canonical = CsrGraph::fromEdges(form.numVertices, std::move(edges));
+    } else {
+        std::vector<std::uint64_t> label = vertexInvariants(g);
+        std::sort(label.begin(), label.end());
+        std::uint64_t h = hashCombine(0x452821e638d01377ULL, g.numVertices);
+        for (std::uint64_t l : label) h = hashCombine(h, l);
+        p.key.high = h;
+        p.key.low = (static_cast<std::uint64_t>(g.numVertices) << 32) | static_cast<std::uint32_t>(g.numEdges());
+    }
+    return p;
+}
+
+int IsoClassIndex::lookup(const CsrView& g, const Prepared& p) const {
+    auto it = buckets.find(p.key);
+    if (it == buckets.end()) return -1;
+    for (int id : it->second) {
+        CsrView rep = classes[id].representative.view();
+        bool same = mode == Fingerprint::Canonical ? sameLabeledGraph(rep, p.canonical.view())
+                                                   : areGraphsIsomorphic(rep, g);
+        if (same) return id;
+    }
+    return -1;
+}
+
+int IsoClassIndex::commit(const CsrView& g, Prepared p) {
+    ++graphCount;
+    int id = lookup(g, p);
+    if (id >= 0) {
+        ++classes[id].size;
+        return id;
+    }
+
+    id = static_cast<int>(classes.size());
+    IsoClass c;
+    c.key = p.key;
+    c.representative = mode == Fingerprint::Canonical ? std::move(p.canonical)
+                                                      : CsrGraph::fromEdges(g.numVertices, csrEdges(g));
+    c.size = 1;
+    classes.push_back(std::move(c));
+    buckets[p.key].push_back(id);
+    return id;
+}
+
+int IsoClassIndex::insert(const Graph& g) {
+    CsrGraph c = CsrGraph::fromGraph(g);
+    return insert(c.view());
+}
+
+int IsoClassIndex::insert(const CsrView& g) {
+    return commit(g, prepare(g));
+}
+
+std::vector<int> IsoClassIndex::insertBatch(const std::vector<CsrView>& graphs, const IsoOptions& options) {
+    std::vector<Prepared> prepared(graphs.size());
+    unsigned threads = resolveThreadCount(options.numThreads);
+    if (threads > 1 && graphs.size() > 1) {
+        // Contiguous chunks, several per worker so stealing can even out
+        // graphs of very different sizes.
+        WorkStealingPool pool(threads);
+        size_t chunk = std::max<size_t>(1, graphs.size() / (threads * 8));
+        for (size_t begin = 0; begin < graphs.size(); begin += chunk) {
+            size_t end = std::min(graphs.size(), begin + chunk);
+            pool.submit([&, begin, end](unsigned) {
+                for (size_t i = begin; i < end; ++i) prepared[i] = prepare(graphs[i]);
+            });
+        }
+        pool.wait();
+    } else {
+        for (size_t i = 0; i < graphs.size(); ++i) prepared[i] = prepare(graphs[i]);
+    }
+
+    std::vector<int> ids(graphs.size());
+    for (size_t i = 0; i < graphs.size(); ++i) ids[i] = commit(graphs[i], std::move(prepared[i]));
+    return ids;
+}
+
+int IsoClassIndex::find(const Graph& g) const {
+    CsrGraph c = CsrGraph::fromGraph(g);
+    return find(c.view());
+}
+
+int IsoClassIndex::find(const CsrView& g) const {
+    return lookup(g, prepare(g));
+}
+
+void IsoClassIndex::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("Cannot create " + path + ".");
+
+    out.write(kMagic, sizeof kMagic);
+    writeValue(out, kByteOrderMark);
+    writeValue(out, kVersion);
+    writeValue(out, static_cast<std::uint32_t>(mode));
+    writeValue(out, static_cast<std::uint32_t>(0));
+    writeValue(out, static_cast<std::uint64_t>(classes.size()));
+    writeValue(out, static_cast<std::uint64_t>(graphCount));
+
+    for (const IsoClass& c : classes) {
+        CsrView rep = c.representative.view();
+        std::vector<CsrEdge> edges = csrEdges(rep);
+        writeValue(out, c.key.high);
+        writeValue(out, c.key.low);
+        writeValue(out, static_cast<std::uint64_t>(c.size));
+        writeValue(out, static_cast<std::int32_t>(rep.numVertices));
+        writeValue(out, static_cast<std::int32_t>(edges.size()));
+        for (const CsrEdge& e : edges) {
+            writeValue(out, static_cast<std::int32_t>(e.from));
+            writeValue(out, static_cast<std::int32_t>(e.to));
+            writeValue(out, static_cast<std::int32_t>(e.weight));
+        }
+    }
+
+    out.close();
+    if (!out) throw std::runtime_error("Failed writing " + path + ".");
+}
+
+IsoClassIndex IsoClassIndex::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("Cannot open " + path + ".");
+
+    char magic[sizeof kMagic];
+    if (!in.read(magic, sizeof magic) || std::memcmp(magic, kMagic, sizeof kMagic) != 0)
+        throw std::runtime_error(path + " is not an isomorphism class index.");
+    if (readValue<std::uint32_t>(in) != kByteOrderMark || readValue<std::uint32_t>(in) != kVersion)
+        throw std::runtime_error(path + " was written with a different byte order or format version.");
+    std::uint32_t storedMode = readValue<std::uint32_t>(in);
+    if (storedMode > static_cast<std::uint32_t>(Fingerprint::Invariants))
+        throw std::runtime_error(path + " has an unknown fingerprint kind.");
+    readValue<std::uint32_t>(in);
+
+    IsoClassIndex index(static_cast<Fingerprint>(storedMode));
+    std::uint64_t numClasses = readValue<std::uint64_t>(in);
+    index.graphCount = static_cast<size_t>(readValue<std::uint64_t>(in));
+
+    for (std::uint64_t id = 0; id < numClasses; ++id) {
+        IsoClass c;
+        c.key.high = readValue<std::uint64_t>(in);
+        c.key.low = readValue<std::uint64_t>(in);
+        c.size = static_cast<size_t>(readValue<std::uint64_t>(in));
+        std::int32_t n = readValue<std::int32_t>(in);
+        std::int32_t m = readValue<std::int32_t>(in);
+        if (n < 0 || m < 0) throw std::runtime_error(path + " is corrupt.");
+
+        std::vector<CsrEdge> edges;
+        for (std::int32_t k = 0; k < m; ++k) {
+            CsrEdge e;
+            e.from = readValue<std::int32_t>(in);
+            e.to = readValue<std::int32_t>(in);
+            e.weight = readValue<std::int32_t>(in);
+            edges.push_back(e);
+        }
+        try {
+            c.representative = CsrGraph::fromEdges(n, std::move(edges));
+        } catch (const std::invalid_argument& e) {
+            throw std::runtime_error(path + " is corrupt: " + e.what());
+        }
+        index.buckets[c.key].push_back(static_cast<int>(id));
+        index.classes.push_back(std::move(c));
+    }
+    return index;
+}
@@ -0,0 +1,88 @@
+#ifndef ISO_CLASS_INDEX_H
+#define ISO_CLASS_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "csr_graph.h"
+#include "graph_utils.h"
+
+// Groups graphs into isomorphism classes. Each graph is reduced to a
+// fingerprint and only compared with the classes sharing it, so inserting
+// N graphs costs N fingerprints rather than N^2 isomorphism checks.
+//
+// Canonical fingerprints are the 128-bit canonical hash. The representative
+// is kept in canonical labeling, so confirming a match is an array compare.
+// Invariant fingerprints fold the pre-filter's vertex invariants; they are
+// cheaper to compute, but matches are confirmed with areGraphsIsomorphic
+// against each class in the bucket.
+class IsoClassIndex {
+public:
+    enum class Fingerprint { Canonical, Invariants };
+
+    explicit IsoClassIndex(Fingerprint mode = Fingerprint::Canonical);
+
+    Fingerprint fingerprint() const { return mode; }
+    size_t numClasses() const { return classes.size(); }
+    size_t numGraphs() const { return graphCount; }
+    size_t classSize(int id) const { return classes[id].size; }
+    // One member of the class; in canonical labeling for Canonical indexes.
+    const CsrGraph& representative(int id) const { return classes[id].representative; }
+
+    // Adds a graph and returns its class id. New classes are numbered
+    // consecutively from 0 in insertion order.
+    int insert(const Graph& g);
+    int insert(const CsrView& g);
+    // Inserts in order, computing the fingerprints on numThreads threads.
+    // Returns the class id of every graph.
+    std::vector<int> insertBatch(const std::vector<CsrView>& graphs, const IsoOptions& options = IsoOptions());
+
+    // Class id of a graph without inserting it, or -1.
+    int find(const Graph& g) const;
+    int find(const CsrView& g) const;
+
+    // Writes the classes (fingerprint, size and representative) to a binary
+    // file; load() restores them, so a later batch only needs comparing
+    // with the stored classes. Both throw std::runtime_error on I/O errors
+    // and load() also on a malformed file. Canonical indexes are only
+    // valid for the canonical labeling that wrote them; the file version
+    // is bumped whenever that changes.
+    void save(const std::string& path) const;
+    static IsoClassIndex load(const std::string& path);
+
+private:
+    struct Key {
+        std::uint64_t high = 0;
+        std::uint64_t low = 0;
+        bool operator==(const Key& other) const { return high == other.high && low == other.low; }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& k) const { return static_cast<size_t>(k.high ^ (k.low * 0x9e3779b97f4a7c15ULL)); }
+    };
+
+    struct IsoClass {
+        Key key;
+        CsrGraph representative;
+        size_t size = 0;
+    };
+
+    // A graph reduced to what insertion needs; computing it is the costly,
+    // thread-safe part.
+    struct Prepared {
+        Key key;
+        CsrGraph canonical;  // Canonical mode only
+    };
+
+    Fingerprint mode;
+    std::vector<IsoClass> classes;
+    std::unordered_map<Key, std::vector<int>, KeyHash> buckets;
+    size_t graphCount = 0;
+
+    Prepared prepare(const CsrView& g) const;
+    int lookup(const CsrView& g, const Prepared& p) const;
+    int commit(const CsrView& g, Prepared p);
+};
+
+#endif // ISO_CLASS_INDEX_H
@@ -0,0 +1,72 @@
+#include "iso_stats.h"
+#include "graph_internal.h"
+#include <cstdio>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+double IsoStats::threadUtilization() const {
+    if (parallelSeconds <= 0 || threads == 0) return 0.0;
+    return busySeconds / (parallelSeconds * threads);
+}
+
+const char* deciderName(IsoStats::Decider decider) {
+    switch (decider) {
+    case IsoStats::Decider::None: return "none";
+    case IsoStats::Decider::Identical: return "identical";
+    case IsoStats::Decider::Prefilter: return "prefilter";
+    case IsoStats::Decider::Matcher: return "matcher";
+    case IsoStats::Decider::Canonical: return "canonical";
+    }
+    return "unknown";
+}
+
+bool isoStatsCounted() {
+    return GRAPHISO_STATS != 0;
+}
+
+std::string isoStatsJson(const IsoStats& s) {
+    char buffer[1024];
+    std::snprintf(buffer, sizeof buffer,
+                  "{\"decided_by\":\"%s\",\"rejected_at\":\"%s\",\"counted\":%s,"
+                  "\"search_nodes\":%lld,\"backtracks\":%lld,\"max_depth\":%d,"
+                  "\"pruned\":{\"color\":%lld,\"degree\":%lld,\"edges\":%lld,\"automorphism\":%lld,\"trace\":%lld},"
+                  "\"canonical_nodes\":%lld,\"refinement_rounds\":%lld,\"automorphisms\":%lld,"
+                  "\"seconds\":{\"prefilter\":%.6f,\"plan\":%.6f,\"match\":%.6f,\"canonical\":%.6f,\"total\":%.6f},"
+                  "\"peak_memory_bytes\":%zu,"
+                  "\"threads\":%u,\"tasks\":%zu,\"busy_seconds\":%.6f,\"parallel_seconds\":%.6f,\"utilization\":%.3f}",
+                  deciderName(s.decidedBy), filterStageName(s.rejectedAt), isoStatsCounted() ? "true" : "false",
+                  s.searchNodes, s.backtracks, s.maxDepth,
+                  s.prunedByColor, s.prunedByDegree, s.prunedByEdges, s.prunedByAutomorphism, s.prunedByTrace,
+                  s.canonicalNodes, s.refinementRounds, s.automorphisms,
+                  s.prefilterSeconds, s.planSeconds, s.matchSeconds, s.canonicalSeconds, s.totalSeconds,
+                  s.peakMemoryBytes,
+                  s.threads, s.tasks, s.busySeconds, s.parallelSeconds, s.threadUtilization());
+    return buffer;
+}
+
+std::size_t peakResidentBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof counters)) return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return static_cast<std::size_t>(usage.ru_maxrss);  // bytes
+#else
+    return static_cast<std::size_t>(usage.ru_maxrss) * 1024;  // kilobytes
+#endif
+#endif
+}
@@ -0,0 +1,73 @@
+#ifndef ISO_STATS_H
+#define ISO_STATS_H
+
+#include <cstddef>
+#include <string>
+#include "graph_utils.h"
+
+// Where one isomorphism check spent its effort. Pass one in
+// IsoOptions::stats and areGraphsIsomorphic overwrites it. The search
+// counters are only recorded when the library is built with GRAPHISO_STATS
+// (the default); without it they stay zero and the phase timings, memory
+// and thread figures are still filled in.
+struct IsoStats {
+    enum class Decider {
+        None,        // the check did not finish
+        Identical,   // equal adjacency matrices
+        Prefilter,   // an invariant differed
+        Matcher,     // backtracking search
+        Canonical,   // canonical forms, after the matcher ran out of budget
+    };
+    Decider decidedBy = Decider::None;
+    FilterStage rejectedAt = FilterStage::Passed;  // set when the prefilter decided
+
+    // Matcher search tree.
+    long long searchNodes = 0;     // pairs added to the partial mapping
+    long long backtracks = 0;      // pairs taken back
+    int maxDepth = 0;              // largest partial mapping
+    long long prunedByColor = 0;   // candidate taken or of another color
+    long long prunedByDegree = 0;  // matched-neighbor counts differ
+    long long prunedByEdges = 0;   // matched edges or their weights differ
+    // Matcher candidates and canonical-search children skipped as lying in
+    // the orbit of one already explored.
+    long long prunedByAutomorphism = 0;
+
+    // Canonical labeling of both graphs.
+    long long canonicalNodes = 0;        // individualization tree nodes
+    long long refinementRounds = 0;      // splitter cells processed
+    long long prunedByTrace = 0;         // children whose trace loses to the best leaf
+    long long automorphisms = 0;         // automorphism generators found
+
+    // Wall-clock seconds per phase.
+    double prefilterSeconds = 0;
+    double planSeconds = 0;
+    double matchSeconds = 0;
+    double canonicalSeconds = 0;
+    double totalSeconds = 0;
+
+    // High-water mark of the whole process's resident memory after the check.
+    std::size_t peakMemoryBytes = 0;
+
+    // Parallel matcher phase: threads used, tasks run, and the summed time
+    // the workers spent in tasks over the phase's wall-clock time.
+    unsigned threads = 1;
+    std::size_t tasks = 0;
+    double busySeconds = 0;
+    double parallelSeconds = 0;
+
+    // Share of the parallel phase the workers spent busy, 0 without one.
+    double threadUtilization() const;
+};
+
+const char* deciderName(IsoStats::Decider decider);
+
+// True when the library was built with the search counters.
+bool isoStatsCounted();
+
+// One JSON object with every field, on a single line.
+std::string isoStatsJson(const IsoStats& stats);
+
+// Peak resident set size of this process in bytes, 0 when unavailable.
+std::size_t peakResidentBytes();
+
+#endif // ISO_STATS_H
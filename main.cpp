@@ -3,16 +3,36 @@
 #include <FL/Fl.H>
 #include <FL/Fl_Window.H>
 #include <FL/Fl_Button.H>
+#include <FL/Fl_Check_Button.H>
 #include <FL/Fl_Text_Display.H>
 #include <FL/Fl_Box.H>
 #include <FL/Fl_Spinner.H>
 #include <FL/Fl_Input.H>
+#include <FL/Fl_Native_File_Chooser.H>
+#include <FL/Fl_Scroll.H>
+#include <FL/fl_draw.H>
+#include <FL/x.H>
 #include <vector>
 #include <iostream>
 #include <sstream>
 #include <algorithm>
 #include <stdexcept>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include "graph_utils.h"
+#include "adjacency_storage.h"
+#include "graph_corpus.h"
+#include "graph_io.h"
+#include "iso_stats.h"
+#include "thread_pool.h"
 
 
 // Function declaration
@@ -26,57 +46,95 @@ Graph graph1;
 Graph graph2;
 Fl_Text_Buffer* textBuffer;
 
+// Fill colors for matched vertex pairs, cycled by vertex index.
+const Fl_Color kMatchPalette[] = {
+    fl_rgb_color(230, 25, 75), fl_rgb_color(60, 180, 75), fl_rgb_color(255, 180, 0), fl_rgb_color(0, 130, 200),
+    fl_rgb_color(245, 130, 48), fl_rgb_color(145, 30, 180), fl_rgb_color(70, 200, 200), fl_rgb_color(240, 50, 230),
+    fl_rgb_color(150, 200, 60), fl_rgb_color(250, 160, 180), fl_rgb_color(0, 128, 128), fl_rgb_color(170, 110, 40),
+};
+
 class GraphWidget : public Fl_Box {
-    const Graph* graph;
+    // Above this many vertices edges lose their weight badges and vertices
+    // their labels, which would only pile up on top of each other.
+    static constexpr int kDetailedVertices = 40;
 
-public:
-    GraphWidget(int x, int y, int w, int h, const char* label = nullptr)
-        : Fl_Box(x, y, w, h, label), graph(nullptr) {}
+    struct Point {
+        int x, y;  // relative to the widget's top-left corner
+    };
 
-    void setGraph(const Graph* g) {
-        graph = g;
+    const Graph* graph;
+    AdjacencyStorage storage;  // packed copy of *graph read by draw()
+    std::vector<int> highlight;  // per vertex: palette slot of its matched pair, or -1
+    unsigned revision_ = 0;      // bumped whenever the graph is replaced
+
+    // Vertex positions for the current graph and size, computed on demand.
+    std::vector<Point> layout;
+    int radius = 25;
+
+    // The whole scene, redrawn only when the graph, highlight or size
+    // changes; draw() itself just copies it to the window.
+    Fl_Offscreen scene = 0;
+    int sceneW = 0, sceneH = 0;
+    bool sceneValid = false;
+
+    void invalidate(bool relayout) {
+        if (relayout) layout.clear();
+        sceneValid = false;
         redraw();
     }
-void draw() override {
-    Fl_Box::draw();
-
-    if (!graph || graph->numVertices == 0) return;
-
-    int radius = 25;          // Radius of vertices
-    int selfLoopOffset = 35;  // Offset for self-loop arcs
-    int edgeWeightRadius = 15; // Radius for edge weight background
-    int centerX = x() + w() / 2, centerY = y() + h() / 2;
-    int vertices = graph->numVertices;
-    double angleStep = 2 * M_PI / vertices;
-
-    // Draw edges and self-loops
-    for (int i = 0; i < vertices; ++i) {
-        int vx = centerX + std::cos(i * angleStep) * (w() / 3);
-        int vy = centerY + std::sin(i * angleStep) * (h() / 3);
-
-        for (int j = 0; j < vertices; ++j) {
-            int weight = graph->adjacencyMatrix[i][j];
-            if (weight > 0) {
+
+    // Vertices evenly spaced on an ellipse, sized to fit their spacing.
+    void computeLayout() {
+        int vertices = storage.numVertices();
+        double angleStep = 2 * M_PI / vertices;
+        layout.resize(vertices);
+        for (int i = 0; i < vertices; ++i) {
+            layout[i].x = w() / 2 + static_cast<int>(std::cos(i * angleStep) * (w() / 3));
+            layout[i].y = h() / 2 + static_cast<int>(std::sin(i * angleStep) * (h() / 3));
+        }
+        double spacing = angleStep * std::min(w(), h()) / 3;
+        radius = std::max(2, std::min(25, static_cast<int>(spacing * 0.4)));
+    }
+
+    void drawEdges() {
+        int vertices = storage.numVertices();
+        bool detailed = vertices <= kDetailedVertices;
+        int selfLoopOffset = radius + 10;  // Offset for self-loop arcs
+        int edgeWeightRadius = 15; // Radius for edge weight background
+
+        for (int i = 0; i < vertices; ++i) {
+            const std::uint64_t* row = storage.bitRow(i);
+            for (int j = i; j < vertices; ++j) {
+                if (row[j >> 6] == 0) {
+                    j |= 63;  // no edges in the rest of this word
+                    continue;
+                }
+                int weight = storage.weight(i, j);
+                if (weight == 0) continue;
+                const Point& v = layout[i];
                 if (i == j) {
                     // Self-loop: Draw as an arc
                     fl_color(fl_rgb_color(255, 100, 100)); // Modern red
-                    fl_arc(vx - selfLoopOffset, vy - selfLoopOffset, selfLoopOffset * 2, selfLoopOffset * 2, 0, 300);
-
-                    // Self-loop weight
-                    fl_color(fl_rgb_color(255, 255, 255)); // White weight text
-                    fl_draw(std::to_string(weight).c_str(), vx + selfLoopOffset, vy - selfLoopOffset - 5);
-                } else if (i < j) {  // Avoid duplicate edges
-                    int wx = centerX + std::cos(j * angleStep) * (w() / 3);
-                    int wy = centerY + std::sin(j * angleStep) * (h() / 3);
+                    fl_arc(v.x - selfLoopOffset, v.y - selfLoopOffset, selfLoopOffset * 2, selfLoopOffset * 2, 0, 300);
+
+                    if (detailed) {
+                        // Self-loop weight
+                        fl_color(fl_rgb_color(255, 255, 255)); // White weight text
+                        fl_draw(std::to_string(weight).c_str(), v.x + selfLoopOffset, v.y - selfLoopOffset - 5);
+                    }
+                    continue;
+                }
 
-                    // Draw edge with variable thickness
-                    fl_color(fl_rgb_color(100, 200, 255)); // Light blue
-                    fl_line_style(FL_SOLID, std::min(3 + weight, 7)); // Thickness based on weight
-                    fl_line(vx, vy, wx, wy);
+                // Draw edge with variable thickness
+                const Point& u = layout[j];
+                fl_color(fl_rgb_color(100, 200, 255)); // Light blue
+                fl_line_style(FL_SOLID, detailed ? std::min(3 + weight, 7) : 1); // Thickness based on weight
+                fl_line(v.x, v.y, u.x, u.y);
 
+                if (detailed) {
                     // Edge weight at midpoint
-                    int mx = (vx + wx) / 2;
-                    int my = (vy + wy) / 2;
+                    int mx = (v.x + u.x) / 2;
+                    int my = (v.y + u.y) / 2;
                     fl_color(fl_rgb_color(50, 50, 50)); // Dark background
                     fl_pie(mx - edgeWeightRadius, my - edgeWeightRadius, edgeWeightRadius * 2, edgeWeightRadius * 2, 0, 360);
                     fl_color(fl_rgb_color(255, 255, 255)); // White text
@@ -84,59 +142,152 @@ void draw() override {
                 }
             }
         }
+        fl_line_style(0); // Reset line style
     }
 
-    // Draw vertices
-    for (int i = 0; i < vertices; ++i) {
-        int vx = centerX + std::cos(i * angleStep) * (w() / 3);
-        int vy = centerY + std::sin(i * angleStep) * (h() / 3);
+    void drawVertices() {
+        int vertices = storage.numVertices();
+        bool labeled = vertices <= kDetailedVertices && radius >= 10;
+        for (int i = 0; i < vertices; ++i) {
+            const Point& v = layout[i];
 
-        // Shadow
-        fl_color(fl_rgb_color(50, 50, 50)); // Dark gray
-        fl_pie(vx - radius - 5, vy - radius - 5, (radius + 5) * 2, (radius + 5) * 2, 0, 360);
+            // Shadow
+            if (labeled) {
+                fl_color(fl_rgb_color(50, 50, 50)); // Dark gray
+                fl_pie(v.x - radius - 5, v.y - radius - 5, (radius + 5) * 2, (radius + 5) * 2, 0, 360);
+            }
 
-        // Border
-        fl_color(fl_rgb_color(80, 200, 120)); // Modern green
-        fl_pie(vx - radius, vy - radius, radius * 2, radius * 2, 0, 360);
+            // Border, in the color of the matched pair after a successful check
+            bool matched = i < static_cast<int>(highlight.size()) && highlight[i] >= 0;
+            fl_color(matched ? kMatchPalette[highlight[i] % (sizeof kMatchPalette / sizeof kMatchPalette[0])]
+                             : fl_rgb_color(80, 200, 120)); // Modern green
+            fl_pie(v.x - radius, v.y - radius, radius * 2, radius * 2, 0, 360);
+            if (!labeled) continue;
 
-        // Label background
-        fl_color(fl_rgb_color(255, 255, 255)); // White
-        fl_pie(vx - radius + 5, vy - radius + 5, (radius - 5) * 2, (radius - 5) * 2, 0, 360);
+            // Label background
+            fl_color(fl_rgb_color(255, 255, 255)); // White
+            fl_pie(v.x - radius + 5, v.y - radius + 5, (radius - 5) * 2, (radius - 5) * 2, 0, 360);
 
-        // Vertex label
-        fl_color(fl_rgb_color(0, 0, 0)); // Black text
-        fl_draw(std::to_string(i + 1).c_str(), vx - 8, vy + 5);
+            // Vertex label
+            fl_color(fl_rgb_color(0, 0, 0)); // Black text
+            fl_draw(std::to_string(i + 1).c_str(), v.x - 8, v.y + 5);
+        }
     }
 
-    fl_line_style(0); // Reset line style
-}
+public:
+    GraphWidget(int x, int y, int w, int h, const char* label = nullptr)
+        : Fl_Box(x, y, w, h, label), graph(nullptr) {}
+
+    ~GraphWidget() override {
+        if (scene) fl_delete_offscreen(scene);
+    }
+
+    void setGraph(const Graph* g) {
+        graph = g;
+        storage = g ? AdjacencyStorage(*g) : AdjacencyStorage();
+        highlight.clear();
+        ++revision_;
+        invalidate(true);
+    }
+
+    unsigned revision() const { return revision_; }
 
+    // Colors vertex v with palette slot slots[v]; an empty vector clears.
+    void setHighlight(std::vector<int> slots) {
+        highlight = std::move(slots);
+        invalidate(false);
+    }
+
+    void resize(int X, int Y, int W, int H) override {
+        bool resized = W != w() || H != h();
+        Fl_Box::resize(X, Y, W, H);
+        if (resized) invalidate(true);
+    }
 
+    void draw() override {
+        if (!graph || storage.numVertices() == 0) {
+            Fl_Box::draw();
+            return;
+        }
+
+        if (!scene || sceneW != w() || sceneH != h()) {
+            if (scene) fl_delete_offscreen(scene);
+            scene = fl_create_offscreen(w(), h());
+            sceneW = w();
+            sceneH = h();
+            sceneValid = false;
+        }
+        if (!sceneValid) {
+            if (layout.empty()) computeLayout();
+            fl_begin_offscreen(scene);
+            draw_box(box(), 0, 0, w(), h(), color());
+            drawEdges();
+            drawVertices();
+            fl_end_offscreen();
+            sceneValid = true;
+        }
+        fl_copy_offscreen(x(), y(), w(), h(), scene, 0, 0);
+        draw_label();
+    }
 };
 
 GraphWidget* graph1Widget;
 GraphWidget* graph2Widget;
 
+// Reads the first graph of a g1.txt-style text file or a graphiso-pack
+// corpus. Throws std::runtime_error when there is none.
+Graph loadGraphFile(const std::string& path) {
+    Graph g;
+    if (GraphCorpus::isCorpusFile(path)) {
+        GraphCorpus corpus(path);
+        if (corpus.size() == 0) throw std::runtime_error(path + " holds no graphs.");
+        CsrView view = corpus.view(0);
+        return CsrGraph::fromEdges(view.numVertices, csrEdges(view)).toGraph();
+    }
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("Cannot open " + path + ".");
+    if (!readGraph(in, g)) throw std::runtime_error(path + " holds no graph.");
+    return g;
+}
+
 class InputDialog : public Fl_Window {
+    // One Fl_Input per matrix cell only scales so far; larger graphs are
+    // loaded from a file instead.
+    static constexpr int kMaxGridVertices = 30;
+
     Graph* targetGraph;
     GraphWidget* targetWidget;
     std::vector<std::vector<Fl_Input*>> matrixInputs;
     Fl_Spinner* vertexSpinner;
+    Fl_Scroll* matrixScroll;
 
 public:
     InputDialog(Graph* graph, GraphWidget* widget, const char* title)
         : Fl_Window(700, 600, title), targetGraph(graph), targetWidget(widget) {
         vertexSpinner = new Fl_Spinner(150, 20, 60, 25, "Vertices:");
         vertexSpinner->minimum(1);
-        vertexSpinner->maximum(10);
-        vertexSpinner->value(graph->numVertices > 0 ? graph->numVertices : 1);
+        vertexSpinner->maximum(kMaxGridVertices);
+        vertexSpinner->value(std::min(std::max(graph->numVertices, 1), kMaxGridVertices));
         vertexSpinner->callback(spinner_callback, this);
 
+        Fl_Box* note = new Fl_Box(230, 20, 440, 25);
+        note->align(FL_ALIGN_LEFT | FL_ALIGN_INSIDE);
+        if (graph->numVertices > kMaxGridVertices)
+            note->copy_label(("This graph has " + std::to_string(graph->numVertices) +
+                              " vertices; load a file to replace it.").c_str());
+        else
+            note->copy_label(("Load graphs over " + std::to_string(kMaxGridVertices) + " vertices from a file.").c_str());
+
+        matrixScroll = new Fl_Scroll(40, 60, 620, 420);
+        matrixScroll->end();
         createMatrix(static_cast<int>(vertexSpinner->value()));
 
-        Fl_Button* createButton = new Fl_Button(250, 500, 100, 30, "Create Graph");
+        Fl_Button* createButton = new Fl_Button(230, 500, 100, 30, "Create Graph");
         createButton->callback(create_callback, this);
 
+        Fl_Button* loadButton = new Fl_Button(350, 500, 130, 30, "Load from File...");
+        loadButton->callback(load_callback, this);
+
         this->end();
     }
 
@@ -150,14 +301,12 @@ public:
         dialog->createGraph();
     }
 
+    static void load_callback(Fl_Widget*, void* v) {
+        InputDialog* dialog = (InputDialog*)v;
+        dialog->loadGraph();
+    }
+
     void recreateMatrix() {
-        for (auto& row : matrixInputs) {
-            for (auto& input : row) {
-                remove(input);
-                delete input;
-            }
-        }
-        matrixInputs.clear();
         createMatrix(static_cast<int>(vertexSpinner->value()));
         this->redraw();
     }
@@ -168,11 +317,12 @@ void createMatrix(int size) {
     // Clear existing inputs
     for (auto& row : matrixInputs) {
         for (auto& input : row) {
-            remove(input);
+            matrixScroll->remove(input);
             delete input;
         }
     }
     matrixInputs.clear();
+    matrixScroll->scroll_to(0, 0);  // new inputs are placed unscrolled
 
     // Resize and populate new inputs
     matrixInputs.resize(size);
@@ -187,6 +337,7 @@ void createMatrix(int size) {
             } else {
                 input->value("0");
             }
+            matrixScroll->add(input);
             matrixInputs[i][j] = input;
         }
     }
@@ -196,7 +347,8 @@ void createMatrix(int size) {
 void createGraph() {
     int size = static_cast<int>(vertexSpinner->value());
     targetGraph->numVertices = size;
-    targetGraph->adjacencyMatrix.resize(size, std::vector<int>(size, 0));
+    // Rows of a larger loaded graph would otherwise keep their old length.
+    targetGraph->adjacencyMatrix.assign(size, std::vector<int>(size, 0));
 
     for (int i = 0; i < size; ++i) {
         for (int j = 0; j < size; ++j) {
@@ -215,6 +367,24 @@ void createGraph() {
     hide();
 }
 
+void loadGraph() {
+    Fl_Native_File_Chooser chooser;
+    chooser.title("Load Graph");
+    chooser.type(Fl_Native_File_Chooser::BROWSE_FILE);
+    if (chooser.show() != 0) return;  // cancelled or failed
+
+    try {
+        *targetGraph = loadGraphFile(chooser.filename());
+    } catch (const std::exception& e) {
+        textBuffer->append((std::string("Error: ") + e.what() + "\n").c_str());
+        return;
+    }
+    textBuffer->append(("Loaded a graph with " + std::to_string(targetGraph->numVertices) + " vertices from " +
+                        chooser.filename() + ".\n").c_str());
+    targetWidget->setGraph(targetGraph);
+    hide();
+}
+
 
 };
 
@@ -251,16 +421,213 @@ void inputGraph2(Fl_Widget*, void*) {
 
 
 
+// A check runs on a worker thread with its own copies of the graphs, so
+// the event loop keeps drawing while it searches. A reporter thread wakes
+// a few times a second, posts progress to the console through Fl::awake
+// and raises the cancel flag once the timeout passes.
+struct CheckJob {
+    Graph first, second;
+    double timeoutSeconds = 0;  // 0 = no timeout
+    bool automorphisms = false;  // also report graph 1's automorphism group
+    std::atomic<bool> cancel{false};
+    std::atomic<bool> timedOut{false};
+    IsoProgress progress;
+    IsoStats stats;
+    IsoMapping match;
+    unsigned revision1 = 0, revision2 = 0;  // widget revisions the graphs were copied at
+
+    std::mutex mutex;
+    std::condition_variable finishedChanged;
+    bool finished = false;
+
+    std::thread worker;
+    std::thread reporter;
+};
+
+std::unique_ptr<CheckJob> runningCheck;  // touched only by the GUI thread
+Fl_Button* checkButton;
+Fl_Button* cancelButton;
+Fl_Spinner* timeoutSpinner;
+Fl_Check_Button* automorphismsCheck;
+int progressLineStart = -1;  // console offset of the live progress line
+
+// Fl::awake handler: replaces the progress line with the latest report.
+void showProgress(void* data) {
+    std::unique_ptr<std::string> line(static_cast<std::string*>(data));
+    if (!runningCheck) return;
+    if (progressLineStart < 0) progressLineStart = textBuffer->length();
+    textBuffer->replace(progressLineStart, textBuffer->length(), line->c_str());
+}
+
+// Fl::awake handler: reports the outcome and rearms the controls.
+void checkFinished(void* data) {
+    std::unique_ptr<std::string> line(static_cast<std::string*>(data));
+    if (runningCheck) {
+        CheckJob& job = *runningCheck;
+        job.worker.join();
+        job.reporter.join();
+        // Pair up matched vertices by color, unless a graph was replaced
+        // while the check ran.
+        if (job.match.isomorphic && graph1Widget->revision() == job.revision1 &&
+            graph2Widget->revision() == job.revision2) {
+            int n = static_cast<int>(job.match.mapping.size());
+            std::vector<int> slots1(n), slots2(n);
+            for (int v = 0; v < n; ++v) {
+                slots1[v] = v;
+                slots2[job.match.mapping[v]] = v;
+            }
+            graph1Widget->setHighlight(std::move(slots1));
+            graph2Widget->setHighlight(std::move(slots2));
+        }
+        runningCheck.reset();
+    }
+    progressLineStart = -1;
+    textBuffer->append(line->c_str());
+    checkButton->activate();
+    cancelButton->deactivate();
+}
+
+void reportProgress(CheckJob* job) {
+    using Clock = std::chrono::steady_clock;
+    const auto interval = std::chrono::milliseconds(250);
+    Clock::time_point start = Clock::now(), last = start;
+    long long lastNodes = 0;
+
+    std::unique_lock<std::mutex> lock(job->mutex);
+    while (!job->finishedChanged.wait_for(lock, interval, [job] { return job->finished; })) {
+        Clock::time_point now = Clock::now();
+        double elapsed = std::chrono::duration<double>(now - start).count();
+        if (job->timeoutSeconds > 0 && elapsed >= job->timeoutSeconds && !job->cancel.load()) {
+            job->timedOut.store(true);
+            job->cancel.store(true);
+        }
+
+        long long nodes = job->progress.nodes.load(std::memory_order_relaxed);
+        double rate = (nodes - lastNodes) / std::chrono::duration<double>(now - last).count();
+        lastNodes = nodes;
+        last = now;
+
+        char text[160];
+        std::snprintf(text, sizeof text, "Searching... %.0f nodes/s, depth %d, %lld nodes, %.1f s\n", rate,
+                      job->progress.depth.load(std::memory_order_relaxed), nodes, elapsed);
+        // Posted under the lock, so no report can overtake the final result.
+        Fl::awake(showProgress, new std::string(text));
+    }
+}
+
+// Console lines for the mapping and, when computed, the automorphism orbits
+// of graph 1, numbering vertices from 1 like the widgets do.
+std::string describeMatch(const IsoMapping& match) {
+    const size_t kMaxListed = 40;
+    std::string text = "  Mapping:";
+    for (size_t v = 0; v < match.mapping.size() && v < kMaxListed; ++v)
+        text += " " + std::to_string(v + 1) + "->" + std::to_string(match.mapping[v] + 1);
+    if (match.mapping.size() > kMaxListed) text += " ...";
+    text += "\n";
+    if (match.orbits.empty()) return text;
+
+    std::vector<std::vector<int>> orbits(match.orbits.size());
+    for (size_t v = 0; v < match.orbits.size(); ++v) orbits[match.orbits[v]].push_back(static_cast<int>(v));
+    text += "  Automorphism group: " + std::to_string(match.generators.size()) + " generators; orbits:";
+    size_t listed = 0;
+    for (const std::vector<int>& orbit : orbits) {
+        if (orbit.empty()) continue;
+        if (++listed > kMaxListed) {
+            text += " ...";
+            break;
+        }
+        text += " {";
+        for (size_t k = 0; k < orbit.size(); ++k) text += (k ? "," : "") + std::to_string(orbit[k] + 1);
+        text += "}";
+    }
+    return text + "\n";
+}
+
+// Console summary of a finished check's statistics.
+std::string describeStats(const IsoStats& s) {
+    char text[512];
+    int length = std::snprintf(text, sizeof text,
+                               "  Decided by %s in %.3f ms (prefilter %.3f, match %.3f, canonical %.3f), peak memory %.1f MB\n",
+                               deciderName(s.decidedBy), s.totalSeconds * 1e3, s.prefilterSeconds * 1e3,
+                               s.matchSeconds * 1e3, s.canonicalSeconds * 1e3, s.peakMemoryBytes / (1024.0 * 1024.0));
+    std::string result(text, std::min<size_t>(length, sizeof text - 1));
+    if (s.decidedBy == IsoStats::Decider::Prefilter) {
+        std::snprintf(text, sizeof text, "  Rejected at: %s\n", filterStageName(s.rejectedAt));
+        result += text;
+    }
+    if (s.searchNodes > 0 || s.backtracks > 0) {
+        std::snprintf(text, sizeof text,
+                      "  Matcher: %lld nodes, %lld backtracks, depth %d; pruned by color %lld, degree %lld, edges %lld\n",
+                      s.searchNodes, s.backtracks, s.maxDepth, s.prunedByColor, s.prunedByDegree, s.prunedByEdges);
+        result += text;
+    }
+    if (s.canonicalNodes > 0) {
+        std::snprintf(text, sizeof text,
+                      "  Canonical: %lld nodes, %lld refinement rounds, %lld automorphisms; pruned by orbit %lld, trace %lld\n",
+                      s.canonicalNodes, s.refinementRounds, s.automorphisms, s.prunedByAutomorphism, s.prunedByTrace);
+        result += text;
+    }
+    if (s.tasks > 0) {
+        std::snprintf(text, sizeof text, "  Threads: %u running %zu tasks, %.0f%% utilized\n", s.threads, s.tasks,
+                      s.threadUtilization() * 100);
+        result += text;
+    }
+    return result;
+}
+
+void runCheck(CheckJob* job) {
+    std::string result;
+    try {
+        IsoOptions options;
+        // Leave a core for the event loop.
+        options.numThreads = std::max(1u, resolveThreadCount(0) - 1);
+        options.cancel = &job->cancel;
+        options.progress = &job->progress;
+        options.stats = &job->stats;
+        options.automorphisms = job->automorphisms;
+        job->match = findIsomorphism(job->first, job->second, options);
+        result = job->match.isomorphic ? "Graphs are isomorphic.\n" + describeMatch(job->match)
+                                       : "Graphs are NOT isomorphic.\n";
+        result += describeStats(job->stats);
+    } catch (const IsoCancelled&) {
+        result = job->timedOut.load() ? "Check timed out.\n" : "Check cancelled.\n";
+    } catch (const std::exception& e) {
+        result = std::string("Error: ") + e.what() + "\n";
+    }
+
+    std::lock_guard<std::mutex> lock(job->mutex);
+    job->finished = true;
+    job->finishedChanged.notify_all();
+    Fl::awake(checkFinished, new std::string(result));
+}
+
 void checkIsomorphism(Fl_Widget*, void*) {
+    if (runningCheck) return;
     if (graph1.numVertices == 0 || graph2.numVertices == 0) {
         textBuffer->append("Error: Create both graphs first.\n");
         return;
     }
 
-bool result = areGraphsIsomorphic(static_cast<const Graph&>(graph1), static_cast<const Graph&>(graph2));
-    textBuffer->append(result ? "Graphs are isomorphic.\n" : "Graphs are NOT isomorphic.\n");
+    runningCheck = std::make_unique<CheckJob>();
+    CheckJob* job = runningCheck.get();
+    job->first = graph1;
+    job->second = graph2;
+    job->timeoutSeconds = timeoutSpinner->value();
+    job->automorphisms = automorphismsCheck->value() != 0;
+    job->revision1 = graph1Widget->revision();
+    job->revision2 = graph2Widget->revision();
+    checkButton->deactivate();
+    cancelButton->activate();
+    job->worker = std::thread(runCheck, job);
+    job->reporter = std::thread(reportProgress, job);
 }
+
+void cancelCheck(Fl_Widget*, void*) {
+    if (runningCheck) runningCheck->cancel.store(true);
+}
+
 int main() {
+    Fl::lock();  // enables Fl::awake from the check threads
     textBuffer = new Fl_Text_Buffer();
 
     Fl_Window* window = new Fl_Window(1200, 800, "Graph Isomorphism Checker");
@@ -278,30 +645,50 @@ int main() {
     buttonGroup->color(fl_rgb_color(220, 250, 220)); // Light gray
     buttonGroup->align(FL_ALIGN_TOP_LEFT);
 
-    Fl_Button* inputGraph1Button = new Fl_Button(60, 80, 200, 30, "Input Graph 1");
+    Fl_Button* inputGraph1Button = new Fl_Button(60, 75, 200, 30, "Input Graph 1");
     inputGraph1Button->color(fl_rgb_color(100, 200, 255)); // Light blue
     inputGraph1Button->labelcolor(FL_WHITE);
     inputGraph1Button->labelfont(FL_BOLD);
     inputGraph1Button->callback(inputGraph1);
 
-    Fl_Button* inputGraph2Button = new Fl_Button(60, 130, 200, 30, "Input Graph 2");
+    Fl_Button* inputGraph2Button = new Fl_Button(60, 110, 200, 30, "Input Graph 2");
     inputGraph2Button->color(fl_rgb_color(100, 200, 255));
     inputGraph2Button->labelcolor(FL_WHITE);
     inputGraph2Button->labelfont(FL_BOLD);
     inputGraph2Button->callback(inputGraph2);
 
-    Fl_Button* checkButton = new Fl_Button(60, 180, 200, 30, "Check Isomorphism");
+    // Off by default: the group costs a canonical labeling of graph 2 up
+    // front, which only pays off on highly symmetric pairs.
+    automorphismsCheck = new Fl_Check_Button(60, 145, 200, 25, "Automorphism group");
+    automorphismsCheck->tooltip("Also compute the automorphism group of graph 1 and prune the search by it");
+
+    checkButton = new Fl_Button(60, 175, 130, 30, "Check Isomorphism");
     checkButton->color(fl_rgb_color(50, 150, 50)); // Green
     checkButton->labelcolor(FL_WHITE);
     checkButton->labelfont(FL_BOLD);
     checkButton->callback(checkIsomorphism);
 
-    Fl_Button* clearButton = new Fl_Button(60, 220, 200, 30, "Clear");
+    cancelButton = new Fl_Button(195, 175, 65, 30, "Cancel");
+    cancelButton->color(fl_rgb_color(200, 150, 50)); // Orange
+    cancelButton->labelcolor(FL_WHITE);
+    cancelButton->labelfont(FL_BOLD);
+    cancelButton->callback(cancelCheck);
+    cancelButton->deactivate();
+
+    Fl_Button* clearButton = new Fl_Button(60, 215, 130, 30, "Clear");
     clearButton->color(fl_rgb_color(200, 50, 50)); // Red
     clearButton->labelcolor(FL_WHITE);
     clearButton->labelfont(FL_BOLD);
     clearButton->callback(clearResults);
 
+    timeoutSpinner = new Fl_Spinner(195, 215, 65, 30, "s");
+    timeoutSpinner->align(FL_ALIGN_RIGHT);
+    timeoutSpinner->tooltip("Timeout for a check in seconds (0 = none)");
+    timeoutSpinner->minimum(0);
+    timeoutSpinner->maximum(3600);
+    timeoutSpinner->step(1);
+    timeoutSpinner->value(30);
+
     buttonGroup->end();
 
     // Text Display Section
@@ -339,5 +726,13 @@ int main() {
     // Show the window
     window->end();
     window->show();
-    return Fl::run();
+    int status = Fl::run();
+
+    // Window closed mid-check: stop the search before the graphs go away.
+    if (runningCheck) {
+        runningCheck->cancel.store(true);
+        runningCheck->worker.join();
+        runningCheck->reporter.join();
+    }
+    return status;
 }
@@ -0,0 +1,558 @@
+#include "matcher.h"
+#include "adjacency_storage.h"
+#include "graph_internal.h"
+#include "graph_utils.h"
+#include "iso_stats.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <queue>
+#include <tuple>
+#include <unordered_map>
+
+namespace {
+
+// Below this size the search is too short to be worth any threads.
+const int kParallelMinVertices = 32;
+// Steps the calling thread tries alone before the search is split.
+const long kSequentialBudget = 20000;
+// Top levels the tree may be split at, and how many tasks to aim for.
+const int kMaxSplitDepth = 4;
+const size_t kTasksPerThread = 16;
+// Search steps allowed per vertex, and at least, before the matcher gives
+// up on an instance. Easy instances need little more than one step per
+// vertex; a step costs up to a degree's worth of work.
+const long kBudgetPerVertex = 16;
+const long kMinBudget = 20000;
+// Steps a search takes from a shared budget at a time.
+const long kStepChunk = 256;
+// Depths at which candidates are pruned by orbits; deeper down few
+// automorphisms fix all the images above.
+const int kMaxOrbitDepth = 32;
+
+void addCounters(IsoStats& stats, const MatchCounters& c) {
+    stats.searchNodes += c.nodes;
+    stats.backtracks += c.backtracks;
+    stats.maxDepth = std::max(stats.maxDepth, c.maxDepth);
+    stats.prunedByColor += c.prunedByColor;
+    stats.prunedByDegree += c.prunedByDegree;
+    stats.prunedByEdges += c.prunedByEdges;
+    stats.prunedByAutomorphism += c.prunedByAutomorphism;
+}
+
+// Takes up to kStepChunk steps from a budget shared between threads; 0
+// once it is spent.
+long claimSteps(std::atomic<long>& shared) {
+    long left = shared.fetch_sub(kStepChunk, std::memory_order_relaxed);
+    return left <= 0 ? 0 : std::min(left, kStepChunk);
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+bool MatchPlan::build(const CsrView& first, const CsrView& second,
+                      const std::vector<std::uint64_t>& color1, const std::vector<std::uint64_t>& color2,
+                      const AdjacencyStorage* dense) {
+    g1 = &first;
+    g2 = &second;
+    dense2 = dense;
+
+    int n = first.numVertices;
+    std::unordered_map<std::uint64_t, int> ids;
+    ids.reserve(n);
+    label1.resize(n);
+    label2.resize(n);
+    for (int v = 0; v < n; ++v)
+        label1[v] = ids.emplace(color1[v], static_cast<int>(ids.size())).first->second;
+    for (int v = 0; v < n; ++v)
+        label2[v] = ids.emplace(color2[v], static_cast<int>(ids.size())).first->second;
+
+    labelFreq.assign(ids.size(), 0);
+    bucketStart.assign(ids.size() + 1, 0);
+    for (int v = 0; v < n; ++v) {
+        ++labelFreq[label1[v]];
+        ++bucketStart[label2[v] + 1];
+    }
+    for (size_t l = 0; l < ids.size(); ++l) {
+        if (bucketStart[l + 1] != labelFreq[l]) return false;
+        bucketStart[l + 1] += bucketStart[l];
+    }
+    bucket.resize(n);
+    std::vector<int> fill(bucketStart.begin(), bucketStart.end() - 1);
+    for (int v = 0; v < n; ++v) bucket[fill[label2[v]]++] = v;
+
+    computeOrder();
+    return true;
+}
+
+// Visit order: components are seeded by their rarest, best connected
+// vertex and grown breadth-first; inside a BFS level the vertex with the
+// most already-ordered neighbors goes first, then the higher degree, then
+// the rarer label.
+void MatchPlan::computeOrder() {
+    const CsrView& g = *g1;
+    int n = g.numVertices;
+    order.clear();
+    parent.assign(n, -1);
+    parentIsTail.assign(n, 0);
+
+    std::vector<int> seeds(n);
+    for (int v = 0; v < n; ++v) seeds[v] = v;
+    std::sort(seeds.begin(), seeds.end(), [&](int a, int b) {
+        if (labelFreq[label1[a]] != labelFreq[label1[b]]) return labelFreq[label1[a]] < labelFreq[label1[b]];
+        return degree(a) > degree(b);
+    });
+
+    std::vector<char> placed(n, 0);
+    std::vector<int> levelOf(n, -1);
+    std::vector<int> conn(n, 0);
+    using Entry = std::tuple<int, int, int, int>;  // conn, degree, -freq, -vertex
+    size_t nextSeed = 0;
+    int levelId = 0;
+
+    while (static_cast<int>(order.size()) < n) {
+        while (levelOf[seeds[nextSeed]] >= 0) ++nextSeed;
+        std::vector<int> level{seeds[nextSeed]};
+        levelOf[seeds[nextSeed]] = levelId;
+
+        while (!level.empty()) {
+            std::vector<int> nextLevel;
+            std::priority_queue<Entry> heap;
+            for (int v : level) heap.emplace(conn[v], degree(v), -labelFreq[label1[v]], -v);
+
+            auto touch = [&](int w) {
+                if (placed[w]) return;
+                ++conn[w];
+                if (levelOf[w] < 0) {
+                    levelOf[w] = levelId + 1;
+                    nextLevel.push_back(w);
+                } else if (levelOf[w] == levelId) {
+                    heap.emplace(conn[w], degree(w), -labelFreq[label1[w]], -w);
+                }
+            };
+
+            while (!heap.empty()) {
+                auto [c, d, f, negV] = heap.top();
+                heap.pop();
+                int v = -negV;
+                if (placed[v] || c != conn[v]) continue;
+                placeVertex(v, placed);
+                for (int k = g.outStart[v]; k < g.outStart[v + 1]; ++k) touch(g.outAdj[k]);
+                for (int k = g.inStart[v]; k < g.inStart[v + 1]; ++k) touch(g.inAdj[k]);
+            }
+            level.swap(nextLevel);
+            ++levelId;
+        }
+    }
+}
+
+// Appends v to the order and picks its lowest-degree ordered neighbor as
+// the parent whose image bounds v's candidate set.
+void MatchPlan::placeVertex(int v, std::vector<char>& placed) {
+    const CsrView& g = *g1;
+    int depth = static_cast<int>(order.size());
+    int best = -1, bestSize = 0;
+    for (int k = g.inStart[v]; k < g.inStart[v + 1]; ++k) {
+        int p = g.inAdj[k];
+        if (placed[p] && (best < 0 || g.outDegree(p) < bestSize)) {
+            best = p;
+            bestSize = g.outDegree(p);
+            parentIsTail[depth] = 1;
+        }
+    }
+    for (int k = g.outStart[v]; k < g.outStart[v + 1]; ++k) {
+        int p = g.outAdj[k];
+        if (placed[p] && (best < 0 || g.inDegree(p) < bestSize)) {
+            best = p;
+            bestSize = g.inDegree(p);
+            parentIsTail[depth] = 0;
+        }
+    }
+    parent[depth] = best;
+    placed[v] = 1;
+    order.push_back(v);
+}
+
+MatchState::MatchState(const MatchPlan& plan) : plan(plan), g1(*plan.g1), g2(*plan.g2) {
+    int n = g1.numVertices;
+    cursor.assign(n + 1, 0);
+    map1.assign(n, -1);
+    map2.assign(n, -1);
+    mark.assign(n, -1);
+    markWeight.assign(n, 0);
+    mappedOut1.assign(n, 0);
+    mappedIn1.assign(n, 0);
+    mappedOut2.assign(n, 0);
+    mappedIn2.assign(n, 0);
+    if (plan.symmetries2 && !plan.symmetries2->empty()) {
+        int depths = std::min(n, kMaxOrbitDepth);
+        tried.resize(depths);
+        orbit.resize(depths);
+        orbitState.assign(depths, 0);
+    }
+}
+
+bool MatchState::extend(int c) {
+    int u = plan.order[depth_];
+    if (map2[c] >= 0 || plan.label2[c] != plan.label1[u] || !feasible(u, c)) return false;
+    assign(u, c);
+    ++depth_;
+    return true;
+}
+
+void MatchState::reset() {
+    while (depth_ > 0) unassign(plan.order[--depth_]);
+}
+
+void MatchState::monitor(const IsoOptions& options) {
+    cancel = options.cancel;
+    progress = options.progress;
+}
+
+long matcherBudget(int numVertices) {
+    return std::max(kMinBudget, kBudgetPerVertex * numVertices);
+}
+
+MatchState::Outcome MatchState::search(long budget, const std::atomic<bool>* stop, std::atomic<long>* sharedBudget) {
+    int n = g1.numVertices;
+    int base = depth_;
+    long steps = 0;
+    long allowance = 0;  // steps claimed from sharedBudget, not yet taken
+    enter(depth_);
+
+    Outcome outcome;
+    while (true) {
+        if (depth_ == n) {
+            outcome = Outcome::Found;
+            break;
+        }
+        ++steps;
+        if ((steps & 255) == 0) {
+            if (progress) {
+                progress->nodes.fetch_add(256, std::memory_order_relaxed);
+                progress->depth.store(depth_, std::memory_order_relaxed);
+            }
+            if (cancel && cancel->load(std::memory_order_relaxed)) {
+                outcome = Outcome::Cancelled;
+                break;
+            }
+            if (stop && stop->load(std::memory_order_relaxed)) {
+                outcome = Outcome::Stopped;
+                break;
+            }
+        }
+        if (sharedBudget) {
+            if (allowance == 0 && (allowance = claimSteps(*sharedBudget)) == 0) {
+                outcome = Outcome::OutOfBudget;
+                break;
+            }
+            --allowance;
+        } else if (budget >= 0 && steps > budget) {
+            outcome = Outcome::OutOfBudget;
+            break;
+        }
+
+        int c = nextCandidate(depth_, cursor[depth_]);
+        if (c >= 0) {
+            assign(plan.order[depth_], c);
+            enter(++depth_);
+            GRAPHISO_STAT(++counters_.nodes);
+            GRAPHISO_STAT(counters_.maxDepth = std::max(counters_.maxDepth, depth_));
+            continue;
+        }
+        if (depth_ == base) {
+            outcome = Outcome::Exhausted;
+            break;
+        }
+        unassign(plan.order[--depth_]);
+        GRAPHISO_STAT(++counters_.backtracks);
+    }
+    if (progress) progress->nodes.fetch_add(steps & 255, std::memory_order_relaxed);
+    if (allowance > 0) sharedBudget->fetch_add(allowance, std::memory_order_relaxed);
+    return outcome;
+}
+
+void MatchState::enumeratePrefixes(int depth, std::vector<std::vector<int>>& out) {
+    int base = depth_;
+    enter(depth_);
+
+    while (true) {
+        if (depth_ == depth) {
+            std::vector<int> images(depth);
+            for (int d = 0; d < depth; ++d) images[d] = map1[plan.order[d]];
+            out.push_back(std::move(images));
+        } else {
+            int c = nextCandidate(depth_, cursor[depth_]);
+            if (c >= 0) {
+                assign(plan.order[depth_], c);
+                enter(++depth_);
+                continue;
+            }
+        }
+        if (depth_ == base) return;
+        unassign(plan.order[--depth_]);
+    }
+}
+
+// Starts a fresh node at this depth.
+void MatchState::enter(int depth) {
+    cursor[depth] = 0;
+    if (depth < static_cast<int>(tried.size())) {
+        tried[depth].clear();
+        orbitState[depth] = 0;
+    }
+}
+
+// Whether an automorphism of g2 fixing the images of order[0 .. depth)
+// maps c onto a candidate already taken at this node. The orbits are only
+// built once a node tries its second candidate.
+bool MatchState::symmetricToTried(int depth, int c) {
+    if (depth >= static_cast<int>(tried.size()) || tried[depth].empty()) return false;
+    if (orbitState[depth] == 0) {
+        std::vector<int>& parent = orbit[depth];
+        parent.resize(g2.numVertices);
+        for (int v = 0; v < g2.numVertices; ++v) parent[v] = v;
+        orbitState[depth] = 2;
+        for (const std::vector<int>& gen : *plan.symmetries2) {
+            bool fixes = true;
+            for (int d = 0; d < depth && fixes; ++d) {
+                int image = map1[plan.order[d]];
+                fixes = gen[image] == image;
+            }
+            if (!fixes) continue;
+            orbitState[depth] = 1;
+            for (int v = 0; v < g2.numVertices; ++v) parent[findRoot(parent, v)] = findRoot(parent, gen[v]);
+        }
+    }
+    if (orbitState[depth] != 1) return false;
+
+    std::vector<int>& parent = orbit[depth];
+    int root = findRoot(parent, c);
+    for (int t : tried[depth]) {
+        if (findRoot(parent, t) == root) return true;
+    }
+    return false;
+}
+
+void MatchState::assign(int u, int c) {
+    map1[u] = c;
+    map2[c] = u;
+    updateMappedCounts(u, c, 1);
+}
+
+void MatchState::unassign(int u) {
+    int c = map1[u];
+    updateMappedCounts(u, c, -1);
+    map2[c] = -1;
+    map1[u] = -1;
+}
+
+void MatchState::updateMappedCounts(int u, int c, int delta) {
+    for (int k = g1.inStart[u]; k < g1.inStart[u + 1]; ++k) mappedOut1[g1.inAdj[k]] += delta;
+    for (int k = g1.outStart[u]; k < g1.outStart[u + 1]; ++k) mappedIn1[g1.outAdj[k]] += delta;
+    for (int k = g2.inStart[c]; k < g2.inStart[c + 1]; ++k) mappedOut2[g2.inAdj[k]] += delta;
+    for (int k = g2.outStart[c]; k < g2.outStart[c + 1]; ++k) mappedIn2[g2.outAdj[k]] += delta;
+}
+
+// Advances the cursor at this depth to the next feasible image of
+// order[depth]; returns -1 once the candidates are exhausted.
+int MatchState::nextCandidate(int depth, int& cursor) {
+    int u = plan.order[depth];
+    int p = plan.parent[depth];
+    const int* list;
+    int size;
+    if (p >= 0) {
+        int pc = map1[p];
+        if (plan.parentIsTail[depth]) {
+            list = g2.outAdj + g2.outStart[pc];
+            size = g2.outDegree(pc);
+        } else {
+            list = g2.inAdj + g2.inStart[pc];
+            size = g2.inDegree(pc);
+        }
+    } else {
+        int l = plan.label1[u];
+        list = plan.bucket.data() + plan.bucketStart[l];
+        size = plan.bucketStart[l + 1] - plan.bucketStart[l];
+    }
+
+    while (cursor < size) {
+        int c = list[cursor++];
+        if (map2[c] >= 0 || plan.label2[c] != plan.label1[u]) {
+            GRAPHISO_STAT(++counters_.prunedByColor);
+            continue;
+        }
+        if (symmetricToTried(depth, c)) {
+            GRAPHISO_STAT(++counters_.prunedByAutomorphism);
+            continue;
+        }
+        if (feasible(u, c)) {
+            if (depth < static_cast<int>(tried.size())) tried[depth].push_back(c);
+            return c;
+        }
+    }
+    return -1;
+}
+
+// The edges between u and the matched vertices must map one-to-one and
+// with equal weight onto the edges between c and their images.
+bool MatchState::feasible(int u, int c) {
+    if (mappedOut1[u] != mappedOut2[c] || mappedIn1[u] != mappedIn2[c]) {
+        GRAPHISO_STAT(++counters_.prunedByDegree);
+        return false;
+    }
+    bool same;
+    if (plan.dense2) {
+        same = sameMappedWeights(u, c);
+    } else {
+        same = sameMappedEdges(g1.outStart, g1.outAdj, g1.outWeight, u, g2.outStart, g2.outAdj, g2.outWeight, c) &&
+               (g1.symmetric ||
+                sameMappedEdges(g1.inStart, g1.inAdj, g1.inWeight, u, g2.inStart, g2.inAdj, g2.inWeight, c));
+    }
+    GRAPHISO_STAT(if (!same) ++counters_.prunedByEdges);
+    return same;
+}
+
+bool MatchState::sameMappedEdges(const int* start1, const int* adj1, const int* weight1, int u,
+                                 const int* start2, const int* adj2, const int* weight2, int c) {
+    ++stamp;
+    int count = 0;
+    for (int k = start2[c]; k < start2[c + 1]; ++k) {
+        int x = adj2[k];
+        if (map2[x] < 0) continue;
+        mark[x] = stamp;
+        markWeight[x] = weight2[k];
+        ++count;
+    }
+    for (int k = start1[u]; k < start1[u + 1]; ++k) {
+        int x = map1[adj1[k]];
+        if (x < 0) continue;
+        if (mark[x] != stamp || markWeight[x] != weight1[k]) return false;
+        --count;
+    }
+    return count == 0;
+}
+
+// With equal matched-neighbor counts it is enough that every matched
+// neighbor of u lands on an edge of c with the same weight.
+bool MatchState::sameMappedWeights(int u, int c) const {
+    for (int k = g1.outStart[u]; k < g1.outStart[u + 1]; ++k) {
+        int x = map1[g1.outAdj[k]];
+        if (x >= 0 && plan.dense2->weight(c, x) != g1.outWeight[k]) return false;
+    }
+    if (g1.symmetric) return true;
+    for (int k = g1.inStart[u]; k < g1.inStart[u + 1]; ++k) {
+        int x = map1[g1.inAdj[k]];
+        if (x >= 0 && plan.dense2->weight(x, c) != g1.inWeight[k]) return false;
+    }
+    return true;
+}
+
+MatchState::Outcome runMatcher(const MatchPlan& plan, const IsoOptions& options, std::vector<int>* mapping) {
+    using Outcome = MatchState::Outcome;
+    int n = plan.g1->numVertices;
+    long budget = matcherBudget(n);
+    unsigned threads = resolveThreadCount(options.numThreads);
+    IsoStats* stats = options.stats;
+    MatchState state(plan);
+    state.monitor(options);
+    if (threads <= 1 || n < kParallelMinVertices) {
+        Outcome outcome = state.search(budget, nullptr);
+        if (stats) addCounters(*stats, state.counters());
+        if (outcome == Outcome::Found && mapping) *mapping = state.mapping();
+        return outcome;
+    }
+
+    // Easy instances finish within the first part of the budget and never
+    // start a thread; the rest is left for the split search.
+    long sequentialSteps = std::min(budget / 4, kSequentialBudget);
+    Outcome outcome = state.search(sequentialSteps, nullptr);
+    if (outcome != Outcome::OutOfBudget) {
+        if (stats) addCounters(*stats, state.counters());
+        if (outcome == Outcome::Found && mapping) *mapping = state.mapping();
+        return outcome;
+    }
+
+    // Split the top levels of the tree until there is enough work to
+    // balance; every prefix is a consistent partial mapping.
+    std::vector<std::vector<int>> prefixes;
+    int depth = 0;
+    while (depth < n && depth < kMaxSplitDepth && prefixes.size() < threads * kTasksPerThread) {
+        ++depth;
+        prefixes.clear();
+        state.reset();
+        state.enumeratePrefixes(depth, prefixes);
+        if (prefixes.empty()) break;
+    }
+    if (stats) addCounters(*stats, state.counters());
+    if (prefixes.empty()) return Outcome::Exhausted;
+    if (depth == n) {
+        if (mapping) {
+            state.reset();
+            for (int c : prefixes.front()) state.extend(c);
+            *mapping = state.mapping();
+        }
+        return Outcome::Found;
+    }
+
+    // All tasks draw their steps from what is left of the one budget, so
+    // a hard pair reaches the canonical fallback after the same amount of
+    // matcher work on any number of threads; the first task to find it
+    // spent stops the others.
+    std::atomic<long> stepsLeft{budget - sequentialSteps};
+    std::atomic<bool> found{false};
+    std::atomic<bool> outOfBudget{false};
+    std::atomic<bool> stop{false};  // set once found or out of budget
+    std::atomic<bool> cancelled{false};
+    std::vector<std::unique_ptr<MatchState>> states(threads);
+    std::vector<double> busy(threads, 0.0);
+    auto parallelStart = std::chrono::steady_clock::now();
+    {
+        WorkStealingPool pool(threads);
+        for (const std::vector<int>& prefix : prefixes) {
+            pool.submit([&, images = &prefix](unsigned worker) {
+                if (stop.load(std::memory_order_relaxed)) return;
+                if (options.cancel && options.cancel->load(std::memory_order_relaxed)) {
+                    cancelled.store(true);
+                    return;
+                }
+                auto taskStart = stats ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+                std::unique_ptr<MatchState>& local = states[worker];
+                if (!local) {
+                    local = std::make_unique<MatchState>(plan);
+                    local->monitor(options);
+                }
+                local->reset();
+                for (int c : *images) local->extend(c);
+                Outcome result = local->search(-1, &stop, &stepsLeft);
+                if (result == Outcome::Found) {
+                    if (!found.exchange(true) && mapping) *mapping = local->mapping();
+                    stop.store(true);
+                } else if (result == Outcome::OutOfBudget) {
+                    outOfBudget.store(true);
+                    stop.store(true);
+                } else if (result == Outcome::Cancelled) {
+                    cancelled.store(true);
+                }
+                if (stats) busy[worker] += secondsSince(taskStart);
+            });
+        }
+        pool.wait();
+    }
+    if (stats) {
+        stats->threads = threads;
+        stats->tasks += prefixes.size();
+        stats->parallelSeconds += secondsSince(parallelStart);
+        for (unsigned t = 0; t < threads; ++t) {
+            stats->busySeconds += busy[t];
+            if (states[t]) addCounters(*stats, states[t]->counters());
+        }
+    }
+    if (found.load()) return Outcome::Found;
+    if (cancelled.load()) return Outcome::Cancelled;
+    return outOfBudget.load() ? Outcome::OutOfBudget : Outcome::Exhausted;
+}
@@ -0,0 +1,141 @@
+#ifndef MATCHER_H
+#define MATCHER_H
+
+// VF2++ style matcher behind areGraphsIsomorphic; not part of the public API.
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "csr_graph.h"
+
+class AdjacencyStorage;
+struct IsoOptions;
+struct IsoProgress;
+
+// Everything about a pair that stays fixed during the search: the vertex
+// colors as dense label ids, the order g1 vertices are matched in, and for
+// each depth the matched neighbor whose image bounds the candidates.
+struct MatchPlan {
+    const CsrView* g1 = nullptr;
+    const CsrView* g2 = nullptr;
+    const AdjacencyStorage* dense2 = nullptr;  // O(1) edge lookups when set
+    // Generators of g2's automorphism group, when known. Candidates that
+    // one of them maps onto an already tried candidate, while fixing the
+    // images above, lead to equivalent subtrees and are skipped.
+    const std::vector<std::vector<int>>* symmetries2 = nullptr;
+
+    std::vector<int> label1, label2;
+    std::vector<int> labelFreq;
+    // g2 vertices by label; those of label l are
+    // bucket[bucketStart[l] .. bucketStart[l + 1]).
+    std::vector<int> bucket, bucketStart;
+
+    std::vector<int> order;
+    std::vector<int> parent;         // per depth: matched neighbor of order[d], or -1
+    std::vector<char> parentIsTail;  // per depth: edge runs parent -> order[d]
+
+    // Vertices may only be matched when their colors agree; any
+    // isomorphism invariant per-vertex value works as a color. Returns
+    // false when the color multisets differ and no mapping can exist.
+    bool build(const CsrView& g1, const CsrView& g2,
+               const std::vector<std::uint64_t>& color1, const std::vector<std::uint64_t>& color2,
+               const AdjacencyStorage* dense2 = nullptr);
+
+private:
+    int degree(int v) const { return g1->outDegree(v) + g1->inDegree(v); }
+    void computeOrder();
+    void placeVertex(int v, std::vector<char>& placed);
+};
+
+// Search tree counters of one MatchState, recorded under GRAPHISO_STATS.
+struct MatchCounters {
+    long long nodes = 0;
+    long long backtracks = 0;
+    int maxDepth = 0;
+    long long prunedByColor = 0;
+    long long prunedByDegree = 0;
+    long long prunedByEdges = 0;
+    long long prunedByAutomorphism = 0;
+};
+
+// Partial mapping plus the scratch arrays to extend it; one per thread.
+class MatchState {
+public:
+    enum class Outcome { Found, Exhausted, Stopped, OutOfBudget, Cancelled };
+
+    explicit MatchState(const MatchPlan& plan);
+
+    // Takes the cancel flag and progress counters of the options into
+    // account in later searches.
+    void monitor(const IsoOptions& options);
+
+    int depth() const { return depth_; }
+    const std::vector<int>& mapping() const { return map1; }
+    const MatchCounters& counters() const { return counters_; }
+
+    // Matches order[depth()] to c when that keeps the mapping consistent.
+    bool extend(int c);
+    // Drops back to the empty mapping.
+    void reset();
+
+    // Searches the subtree below the current mapping. A negative budget
+    // means no limit on the number of steps; with `sharedBudget` the steps
+    // are drawn from it instead, in chunks, together with every other
+    // search sharing it. `stop` and the monitored cancel flag are polled
+    // periodically. Exhausted leaves the mapping as it was on entry.
+    Outcome search(long budget, const std::atomic<bool>* stop, std::atomic<long>* sharedBudget = nullptr);
+
+    // Appends the images of order[0 .. depth) for every consistent mapping
+    // of that many vertices below the current one.
+    void enumeratePrefixes(int depth, std::vector<std::vector<int>>& out);
+
+private:
+    const MatchPlan& plan;
+    const CsrView& g1;
+    const CsrView& g2;
+
+    int depth_ = 0;
+    MatchCounters counters_;
+    const std::atomic<bool>* cancel = nullptr;
+    IsoProgress* progress = nullptr;
+    std::vector<int> cursor;
+    std::vector<int> map1, map2;
+    std::vector<int> mark, markWeight;
+    int stamp = 0;
+    // Matched out-/in-neighbors per vertex, kept current as pairs are
+    // added and removed.
+    std::vector<int> mappedOut1, mappedIn1, mappedOut2, mappedIn2;
+    // Orbit pruning, per depth: candidates taken at the current node, and
+    // a union-find of g2 under the generators that fix the images above.
+    std::vector<std::vector<int>> tried;
+    std::vector<std::vector<int>> orbit;
+    std::vector<char> orbitState;  // 0 = not built, 1 = built, 2 = no generator fixes the images
+
+    void enter(int depth);
+    bool symmetricToTried(int depth, int c);
+    void assign(int u, int c);
+    void unassign(int u);
+    void updateMappedCounts(int u, int c, int delta);
+    int nextCandidate(int depth, int& cursor);
+    bool feasible(int u, int c);
+    bool sameMappedEdges(const int* start1, const int* adj1, const int* weight1, int u,
+                         const int* start2, const int* adj2, const int* weight2, int c);
+    bool sameMappedWeights(int u, int c) const;
+};
+
+// Steps runMatcher allows the search before giving up on a pair with this
+// many vertices, on any number of threads.
+long matcherBudget(int numVertices);
+
+// Runs the search, splitting it across a work-stealing pool when the
+// options allow more than one thread and the instance is not trivially
+// small or easy. The search is capped at a step budget proportional to the
+// graph size: pairs the color classes barely constrain, like regular or
+// CFI graphs, make plain backtracking exponential, and OutOfBudget hands
+// them back to the caller to decide by canonical forms. Adds its counters,
+// thread figures and parallel timings to options.stats when given.
+// On Found the mapping (g1 vertex -> g2 vertex) is stored in `mapping`
+// when given.
+MatchState::Outcome runMatcher(const MatchPlan& plan, const IsoOptions& options, std::vector<int>* mapping = nullptr);
+
+#endif // MATCHER_H
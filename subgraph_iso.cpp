@@ -0,0 +1,517 @@
+#include "subgraph_iso.h"
+#include "adjacency_storage.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+namespace {
+
+using Word = std::uint64_t;
+
+// Hosts smaller than this are searched on the calling thread.
+const int kParallelMinHost = 64;
+// Top levels the tree may be split at, and how many tasks to aim for.
+const int kMaxSplitDepth = 3;
+const size_t kTasksPerThread = 16;
+
+inline int lowestBit(Word x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    return static_cast<int>(std::bitset<64>((x & (0 - x)) - 1).count());
+#endif
+}
+
+// Everything about a pattern/host pair that stays fixed during the
+// search: host adjacency bitsets, the filtered candidate domain of every
+// pattern vertex, and the order pattern vertices are matched in.
+class SubgraphProblem {
+public:
+    SubgraphProblem(const Graph& pattern, const Graph& host, const SubgraphOptions& match)
+        : pattern(pattern), match(match), np(pattern.numVertices), nh(host.numVertices),
+          words((host.numVertices + 63) / 64), hostOut(host) {
+        hostSymmetric = isSymmetric(host);
+        patternSymmetric = isSymmetric(pattern);
+        if (!hostSymmetric) {
+            // In-neighbor sets, transposed from the out-neighbor bitsets.
+            hostInBits.assign(static_cast<size_t>(nh) * words, 0);
+            for (int v = 0; v < nh; ++v) {
+                const Word* row = hostOut.bitRow(v);
+                for (size_t k = 0; k < words; ++k) {
+                    for (Word bits = row[k]; bits; bits &= bits - 1) {
+                        int w = static_cast<int>(k * 64) + lowestBit(bits);
+                        hostInBits[w * words + (v >> 6)] |= Word(1) << (v & 63);
+                    }
+                }
+            }
+        }
+
+        patternOut.resize(np);
+        patternIn.resize(np);
+        for (int u = 0; u < np; ++u) {
+            for (int x = 0; x < np; ++x) {
+                if (u == x || pattern.adjacencyMatrix[u][x] == 0) continue;
+                patternOut[u].push_back(x);
+                patternIn[x].push_back(u);
+            }
+        }
+    }
+
+    const Graph& pattern;
+    const SubgraphOptions match;
+    const int np, nh;
+    const size_t words;  // bitset words per host vertex set
+
+    AdjacencyStorage hostOut;
+    bool hostSymmetric = true;
+
+    std::vector<std::vector<int>> patternOut, patternIn;  // neighbors, self-loops left out
+    std::vector<Word> domain;                             // np rows of `words`
+
+    std::vector<int> order;
+    // Per depth: earlier pattern vertices p with an edge p -> order[d]
+    // (candidates must be host out-neighbors of p's image), with an edge
+    // order[d] -> p (host in-neighbors), and those whose pairs with
+    // order[d] need their weights checked.
+    std::vector<std::vector<int>> earlierTails, earlierHeads, checked;
+
+    const Word* domainRow(int u) const { return domain.data() + u * words; }
+    // Bitset of v's host in-neighbors.
+    const Word* hostInRow(int v) const { return hostSymmetric ? hostOut.bitRow(v) : hostInBits.data() + v * words; }
+
+    // Whether a pattern cell may land on a host cell. A pattern edge needs
+    // a host edge whatever the weight rule; a missing host edge does not
+    // count as weight 0.
+    bool cellFits(int patternWeight, int hostWeight) const {
+        if (patternWeight == 0) return match.mode == SubgraphOptions::Mode::Subgraph || hostWeight == 0;
+        if (hostWeight == 0) return false;
+        if (match.weights == SubgraphOptions::Weights::Exact) return hostWeight == patternWeight;
+        return hostWeight >= patternWeight;
+    }
+
+    // Filters the domains and fixes the order; false when some pattern
+    // vertex has no candidate left.
+    bool build() {
+        buildDomains();
+        if (!enforceArcConsistency()) return false;
+        computeOrder();
+        return true;
+    }
+
+private:
+    std::vector<Word> hostInBits;  // `words` per host vertex; empty when the host is symmetric
+    bool patternSymmetric = true;
+
+    static bool isSymmetric(const Graph& g) {
+        for (int i = 0; i < g.numVertices; ++i)
+            for (int j = 0; j < i; ++j)
+                if (g.adjacencyMatrix[i][j] != g.adjacencyMatrix[j][i]) return false;
+        return true;
+    }
+
+    // Degrees of the neighbors, largest first.
+    static std::vector<int> neighborDegrees(const std::vector<int>& neighbors, const std::vector<int>& degree) {
+        std::vector<int> result;
+        result.reserve(neighbors.size());
+        for (int x : neighbors) result.push_back(degree[x]);
+        std::sort(result.rbegin(), result.rend());
+        return result;
+    }
+
+    // v can only host u when its loop fits, it has at least as many out-
+    // and in-neighbors, and its neighbors' degrees dominate those of u's
+    // neighbors one for one, largest against largest.
+    void buildDomains() {
+        std::vector<std::vector<int>> hostOutNb(nh), hostInNb(nh);
+        for (int v = 0; v < nh; ++v) {
+            for (int w = 0; w < nh; ++w) {
+                if (v == w || !hostOut.hasEdge(v, w)) continue;
+                hostOutNb[v].push_back(w);
+                hostInNb[w].push_back(v);
+            }
+        }
+        std::vector<int> hostDegree(nh), patternDegree(np);
+        for (int v = 0; v < nh; ++v) hostDegree[v] = static_cast<int>(hostOutNb[v].size() + hostInNb[v].size());
+        for (int u = 0; u < np; ++u) patternDegree[u] = static_cast<int>(patternOut[u].size() + patternIn[u].size());
+
+        std::vector<std::vector<int>> hostOutDegrees(nh), hostInDegrees(nh);
+        for (int v = 0; v < nh; ++v) {
+            hostOutDegrees[v] = neighborDegrees(hostOutNb[v], hostDegree);
+            hostInDegrees[v] = neighborDegrees(hostInNb[v], hostDegree);
+        }
+        auto dominates = [](const std::vector<int>& host, const std::vector<int>& pat) {
+            if (host.size() < pat.size()) return false;
+            for (size_t i = 0; i < pat.size(); ++i)
+                if (host[i] < pat[i]) return false;
+            return true;
+        };
+
+        domain.assign(static_cast<size_t>(np) * words, 0);
+        for (int u = 0; u < np; ++u) {
+            std::vector<int> outDegrees = neighborDegrees(patternOut[u], patternDegree);
+            std::vector<int> inDegrees = neighborDegrees(patternIn[u], patternDegree);
+            Word* row = domain.data() + u * words;
+            for (int v = 0; v < nh; ++v) {
+                if (!cellFits(pattern.adjacencyMatrix[u][u], hostOut.weight(v, v))) continue;
+                if (!dominates(hostOutDegrees[v], outDegrees) || !dominates(hostInDegrees[v], inDegrees)) continue;
+                row[v >> 6] |= Word(1) << (v & 63);
+            }
+        }
+    }
+
+    static bool intersects(const Word* a, const Word* b, size_t words) {
+        for (size_t k = 0; k < words; ++k)
+            if (a[k] & b[k]) return true;
+        return false;
+    }
+
+    // Drops v from u's domain while some pattern neighbor x of u has no
+    // candidate among v's host neighbors in the matching direction.
+    bool enforceArcConsistency() {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (int u = 0; u < np; ++u) {
+                Word* row = domain.data() + u * words;
+                bool empty = true;
+                for (size_t k = 0; k < words; ++k) {
+                    for (Word bits = row[k]; bits; bits &= bits - 1) {
+                        int v = static_cast<int>(k * 64) + lowestBit(bits);
+                        bool supported = true;
+                        for (int x : patternOut[u])
+                            if (!(supported = intersects(hostOut.bitRow(v), domainRow(x), words))) break;
+                        for (size_t i = 0; supported && i < patternIn[u].size(); ++i)
+                            supported = intersects(hostInRow(v), domainRow(patternIn[u][i]), words);
+                        if (!supported) {
+                            row[k] &= ~(Word(1) << (v & 63));
+                            changed = true;
+                        }
+                    }
+                    if (row[k]) empty = false;
+                }
+                if (empty) return false;
+            }
+        }
+        return true;
+    }
+
+    int domainSize(int u) const {
+        int size = 0;
+        for (size_t k = 0; k < words; ++k) size += static_cast<int>(std::bitset<64>(domainRow(u)[k]).count());
+        return size;
+    }
+
+    // Most already ordered neighbors first, then the smallest domain, then
+    // the highest degree, so every level is as constrained as possible.
+    void computeOrder() {
+        std::vector<int> size(np), connections(np, 0);
+        for (int u = 0; u < np; ++u) size[u] = domainSize(u);
+        std::vector<char> placed(np, 0);
+        for (int d = 0; d < np; ++d) {
+            int best = -1;
+            for (int u = 0; u < np; ++u) {
+                if (placed[u]) continue;
+                auto key = [&](int w) {
+                    return std::make_tuple(connections[w], -size[w],
+                                           static_cast<int>(patternOut[w].size() + patternIn[w].size()));
+                };
+                if (best < 0 || key(u) > key(best)) best = u;
+            }
+            placed[best] = 1;
+            order.push_back(best);
+            for (int x : patternOut[best]) ++connections[x];
+            for (int x : patternIn[best]) ++connections[x];
+        }
+
+        std::vector<int> depthOf(np);
+        for (int d = 0; d < np; ++d) depthOf[order[d]] = d;
+        earlierTails.assign(np, {});
+        earlierHeads.assign(np, {});
+        checked.assign(np, {});
+        for (int d = 0; d < np; ++d) {
+            int u = order[d];
+            for (int p : patternIn[u])
+                if (depthOf[p] < d) earlierTails[d].push_back(p);
+            // Undirected on both sides: the tails already are the heads.
+            if (!(patternSymmetric && hostSymmetric)) {
+                for (int p : patternOut[u])
+                    if (depthOf[p] < d) earlierHeads[d].push_back(p);
+            }
+            for (int e = 0; e < d; ++e) {
+                int p = order[e];
+                bool adjacent = pattern.adjacencyMatrix[p][u] != 0 || pattern.adjacencyMatrix[u][p] != 0;
+                if (adjacent || match.mode == SubgraphOptions::Mode::Induced) checked[d].push_back(p);
+            }
+        }
+    }
+};
+
+// Partial embedding plus the per-depth candidate bitsets; one per thread.
+class SubgraphSearch {
+public:
+    enum class Outcome { Completed, Stopped, Cancelled };
+    using Visitor = std::function<bool(const std::vector<int>& embedding)>;
+
+    SubgraphSearch(const SubgraphProblem& problem, const IsoOptions& options)
+        : problem(problem), options(options), map(problem.np, -1), used(problem.words, 0),
+          candidates(static_cast<size_t>(problem.np) * problem.words, 0), cursor(problem.np, 0) {}
+
+    int depth() const { return depth_; }
+
+    // Matches order[depth()] to v when that keeps the embedding valid.
+    bool extend(int v) {
+        prepare(depth_);
+        cursor[depth_] = v;
+        if (next(depth_) != v) return false;
+        assign(problem.order[depth_++], v);
+        return true;
+    }
+
+    void reset() {
+        while (depth_ > 0) unassign(problem.order[--depth_]);
+    }
+
+    // Passes every valid extension of the current prefix to order[0 ..
+    // leafDepth) to visit, as pattern vertex -> host vertex with -1 for
+    // unmatched vertices, until visit returns false or `stop` is raised.
+    Outcome search(int leafDepth, const Visitor& visit, const std::atomic<bool>* stop) {
+        if (depth_ == leafDepth) return visit(map) ? Outcome::Completed : Outcome::Stopped;
+        int base = depth_;
+        long steps = 0;
+        prepare(depth_);
+
+        Outcome outcome;
+        while (true) {
+            if ((++steps & 255) == 0) {
+                if (options.progress) {
+                    options.progress->nodes.fetch_add(256, std::memory_order_relaxed);
+                    options.progress->depth.store(depth_, std::memory_order_relaxed);
+                }
+                if (options.cancel && options.cancel->load(std::memory_order_relaxed)) {
+                    outcome = Outcome::Cancelled;
+                    break;
+                }
+                if (stop && stop->load(std::memory_order_relaxed)) {
+                    outcome = Outcome::Stopped;
+                    break;
+                }
+            }
+
+            int v = next(depth_);
+            if (v >= 0) {
+                assign(problem.order[depth_++], v);
+                if (depth_ < leafDepth) {
+                    prepare(depth_);
+                    continue;
+                }
+                bool more = visit(map);
+                unassign(problem.order[--depth_]);
+                if (!more) {
+                    outcome = Outcome::Stopped;
+                    break;
+                }
+                continue;
+            }
+            if (depth_ == base) {
+                outcome = Outcome::Completed;
+                break;
+            }
+            unassign(problem.order[--depth_]);
+        }
+        if (options.progress) options.progress->nodes.fetch_add(steps & 255, std::memory_order_relaxed);
+        return outcome;
+    }
+
+private:
+    const SubgraphProblem& problem;
+    const IsoOptions& options;
+    int depth_ = 0;
+    std::vector<int> map;
+    std::vector<Word> used;
+    std::vector<Word> candidates;  // np rows of `words`
+    std::vector<int> cursor;
+
+    void assign(int u, int v) {
+        map[u] = v;
+        used[v >> 6] |= Word(1) << (v & 63);
+    }
+
+    void unassign(int u) {
+        int v = map[u];
+        used[v >> 6] &= ~(Word(1) << (v & 63));
+        map[u] = -1;
+    }
+
+    // Candidates of order[d]: its domain, minus used host vertices, within
+    // the host neighborhoods of the images of its earlier neighbors.
+    void prepare(int d) {
+        size_t words = problem.words;
+        Word* row = candidates.data() + d * words;
+        const Word* dom = problem.domainRow(problem.order[d]);
+        for (size_t k = 0; k < words; ++k) row[k] = dom[k] & ~used[k];
+        for (int p : problem.earlierTails[d]) {
+            const Word* nb = problem.hostOut.bitRow(map[p]);
+            for (size_t k = 0; k < words; ++k) row[k] &= nb[k];
+        }
+        for (int p : problem.earlierHeads[d]) {
+            const Word* nb = problem.hostInRow(map[p]);
+            for (size_t k = 0; k < words; ++k) row[k] &= nb[k];
+        }
+        cursor[d] = 0;
+    }
+
+    // Advances the cursor at depth d to the next candidate whose cells
+    // with the earlier images fit; -1 once the candidates are exhausted.
+    int next(int d) {
+        const Word* row = candidates.data() + d * problem.words;
+        int u = problem.order[d];
+        const Graph& pattern = problem.pattern;
+        while (cursor[d] < problem.nh) {
+            size_t k = static_cast<size_t>(cursor[d]) >> 6;
+            Word bits = row[k] & (~Word(0) << (cursor[d] & 63));
+            while (!bits && ++k < problem.words) bits = row[k];
+            if (!bits) break;
+            int v = static_cast<int>(k * 64) + lowestBit(bits);
+            cursor[d] = v + 1;
+
+            bool fits = true;
+            for (int p : problem.checked[d]) {
+                int image = map[p];
+                if (!problem.cellFits(pattern.adjacencyMatrix[p][u], problem.hostOut.weight(image, v)) ||
+                    !problem.cellFits(pattern.adjacencyMatrix[u][p], problem.hostOut.weight(v, image))) {
+                    fits = false;
+                    break;
+                }
+            }
+            if (fits) return v;
+        }
+        cursor[d] = problem.nh;
+        return -1;
+    }
+};
+
+enum class Goal { First, Count, Enumerate };
+
+// Shared driver of the three entry points. `visit` is called for every
+// embedding, serialized, until it returns false.
+long long runSubgraphSearch(const Graph& pattern, const Graph& host, const SubgraphOptions& match,
+                            const IsoOptions& options, Goal goal, const EmbeddingCallback& visit) {
+    // The empty pattern has exactly one, empty, embedding.
+    if (pattern.numVertices == 0) {
+        if (goal != Goal::Count) visit(std::vector<int>());
+        return 1;
+    }
+    if (pattern.numVertices > host.numVertices) return 0;
+
+    SubgraphProblem problem(pattern, host, match);
+    if (!problem.build()) return 0;
+    int np = problem.np;
+
+    unsigned threads = resolveThreadCount(options.numThreads);
+    if (threads <= 1 || np < 2 || problem.nh < kParallelMinHost) {
+        SubgraphSearch search(problem, options);
+        long long count = 0;
+        SubgraphSearch::Outcome outcome = search.search(np, [&](const std::vector<int>& embedding) {
+            ++count;
+            return goal == Goal::Count || visit(embedding);
+        }, nullptr);
+        if (outcome == SubgraphSearch::Outcome::Cancelled) throw IsoCancelled();
+        return count;
+    }
+
+    // Split the top levels of the tree into prefixes, as the isomorphism
+    // matcher does, leaving at least one level to every task.
+    SubgraphSearch splitter(problem, options);
+    std::vector<std::vector<int>> prefixes;
+    int depth = 0;
+    while (depth < np - 1 && depth < kMaxSplitDepth && prefixes.size() < threads * kTasksPerThread) {
+        ++depth;
+        prefixes.clear();
+        splitter.reset();
+        SubgraphSearch::Outcome outcome = splitter.search(depth, [&](const std::vector<int>& embedding) {
+            std::vector<int> images(depth);
+            for (int d = 0; d < depth; ++d) images[d] = embedding[problem.order[d]];
+            prefixes.push_back(std::move(images));
+            return true;
+        }, nullptr);
+        if (outcome == SubgraphSearch::Outcome::Cancelled) throw IsoCancelled();
+        if (prefixes.empty()) return 0;
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<bool> cancelled{false};
+    std::mutex visitMutex;
+    std::exception_ptr visitError;
+    std::vector<long long> counts(threads, 0);
+    std::vector<std::unique_ptr<SubgraphSearch>> searches(threads);
+    {
+        WorkStealingPool pool(threads);
+        for (const std::vector<int>& prefix : prefixes) {
+            pool.submit([&, images = &prefix](unsigned worker) {
+                if (stop.load(std::memory_order_relaxed)) return;
+                std::unique_ptr<SubgraphSearch>& local = searches[worker];
+                if (!local) local = std::make_unique<SubgraphSearch>(problem, options);
+                local->reset();
+                for (int v : *images) local->extend(v);
+
+                SubgraphSearch::Outcome outcome = local->search(np, [&](const std::vector<int>& embedding) {
+                    if (goal == Goal::Count) {
+                        ++counts[worker];
+                        return true;
+                    }
+                    std::lock_guard<std::mutex> lock(visitMutex);
+                    if (stop.load()) return false;
+                    ++counts[worker];
+                    bool more = false;
+                    try {
+                        more = visit(embedding);
+                    } catch (...) {
+                        visitError = std::current_exception();
+                    }
+                    if (!more) stop.store(true);
+                    return more;
+                }, &stop);
+                if (outcome == SubgraphSearch::Outcome::Cancelled) {
+                    cancelled.store(true);
+                    stop.store(true);
+                }
+            });
+        }
+        pool.wait();
+    }
+    if (visitError) std::rethrow_exception(visitError);
+    if (cancelled.load()) throw IsoCancelled();
+
+    long long total = 0;
+    for (long long c : counts) total += c;
+    return total;
+}
+
+} // namespace
+
+bool findSubgraph(const Graph& pattern, const Graph& host, const SubgraphOptions& match,
+                  std::vector<int>& embedding, const IsoOptions& options) {
+    bool found = false;
+    runSubgraphSearch(pattern, host, match, options, Goal::First, [&](const std::vector<int>& e) {
+        embedding = e;
+        found = true;
+        return false;
+    });
+    return found;
+}
+
+long long countSubgraphs(const Graph& pattern, const Graph& host, const SubgraphOptions& match,
+                         const IsoOptions& options) {
+    return runSubgraphSearch(pattern, host, match, options, Goal::Count, EmbeddingCallback());
+}
+
+long long enumerateSubgraphs(const Graph& pattern, const Graph& host, const SubgraphOptions& match,
+                             const EmbeddingCallback& callback, const IsoOptions& options) {
+    return runSubgraphSearch(pattern, host, match, options, Goal::Enumerate, callback);
+}
@@ -0,0 +1,47 @@
+#ifndef SUBGRAPH_ISO_H
+#define SUBGRAPH_ISO_H
+
+#include <functional>
+#include <vector>
+#include "graph_utils.h"
+
+// Pattern matching inside a larger host graph. An embedding maps pattern
+// vertex v to host vertex embedding[v], injectively. Every pattern edge,
+// self-loops included, must land on a host edge whose weight satisfies the
+// weight rule; in induced mode pattern non-edges must also land on host
+// non-edges. Edges are read from adjacencyMatrix, so directed matrices
+// are matched direction for direction.
+struct SubgraphOptions {
+    enum class Mode {
+        Subgraph,  // host may have extra edges among the image vertices
+        Induced,   // the image vertices span exactly the pattern's edges
+    };
+    enum class Weights {
+        Exact,    // host weight equals the pattern weight
+        AtLeast,  // host weight reaches the pattern weight, as a threshold
+    };
+    Mode mode = Mode::Subgraph;
+    Weights weights = Weights::Exact;
+};
+
+// Receives each embedding; returning false ends the enumeration. Calls are
+// serialized, even when the search runs on several threads.
+using EmbeddingCallback = std::function<bool(const std::vector<int>& embedding)>;
+
+// The search runs on IsoOptions::numThreads threads and honors its cancel
+// flag and progress counters; cancelling throws IsoCancelled. Matching is
+// a backtracking search over bitset candidate domains that are narrowed
+// up front by degree and neighbor-degree filtering and arc consistency.
+
+// First embedding found, if any, in `embedding`.
+bool findSubgraph(const Graph& pattern, const Graph& host, const SubgraphOptions& match,
+                  std::vector<int>& embedding, const IsoOptions& options = IsoOptions());
+// Number of distinct embeddings; automorphic images count separately.
+long long countSubgraphs(const Graph& pattern, const Graph& host, const SubgraphOptions& match,
+                         const IsoOptions& options = IsoOptions());
+// Passes every embedding to callback, in no particular order when the
+// search is parallel; returns how many were passed.
+long long enumerateSubgraphs(const Graph& pattern, const Graph& host, const SubgraphOptions& match,
+                             const EmbeddingCallback& callback, const IsoOptions& options = IsoOptions());
+
+#endif // SUBGRAPH_ISO_H
@@ -0,0 +1,89 @@
+#include <random>
+#include "graph_canon.h"
+#include "graph_generators.h"
+#include "test_graphs.h"
+#include "test_support.h"
+
+// Whether gen maps every edge of g onto an edge of the same weight.
+static bool isAutomorphism(const CsrGraph& g, const std::vector<int>& gen) {
+    for (const CsrEdge& e : csrEdges(g)) {
+        if (g.weight(gen[e.from], gen[e.to]) != e.weight) return false;
+    }
+    return true;
+}
+
+static void expectCanonicalUnderRelabeling(const CsrGraph& g, std::uint64_t seed = 1) {
+    std::mt19937_64 rng(seed);
+    CsrGraph h = relabeledGraph(g, rng);
+    CanonicalForm a = canonicalForm(g.view());
+    CanonicalForm b = canonicalForm(h.view());
+    CHECK(a.hash == b.hash);
+    CHECK(a == b);
+    for (const std::vector<int>& gen : a.generators) CHECK(isAutomorphism(g, gen));
+}
+
+TEST_CASE(equalForRelabeledCopies) {
+    std::mt19937_64 rng(7);
+    expectCanonicalUnderRelabeling(starGraph(40));
+    expectCanonicalUnderRelabeling(edgelessGraph(40));
+    expectCanonicalUnderRelabeling(perfectMatching(40));
+    expectCanonicalUnderRelabeling(cycleGraph(41));
+    expectCanonicalUnderRelabeling(paleyGraph(37));
+    expectCanonicalUnderRelabeling(gridGraph(6, 7, true));
+    for (std::uint64_t seed = 0; seed < 20; ++seed)
+        expectCanonicalUnderRelabeling(erdosRenyiGraph(60, 4.0, rng, 3), seed);
+}
+
+TEST_CASE(differsForNonIsomorphicGraphs) {
+    std::vector<CsrEdge> triangles;
+    for (int base : {0, 3}) {
+        for (int i = 0; i < 3; ++i) addUndirectedEdge(triangles, base + i, base + (i + 1) % 3);
+    }
+    CHECK(canonicalForm(cycleGraph(6).view()) != canonicalForm(CsrGraph::fromEdges(6, triangles).view()));
+
+    std::mt19937_64 rng(3);
+    CsrGraph g = erdosRenyiGraph(50, 5.0, rng);
+    CHECK(canonicalForm(g.view()) != canonicalForm(nearMissGraph(g, rng).view()));
+}
+
+// Split over several threads the search visits the subtrees in another
+// order, but still ends at the same canonical leaf and finds the group.
+TEST_CASE(sameFormOnSeveralThreads) {
+    std::mt19937_64 rng(13);
+    IsoOptions options;
+    options.numThreads = 4;
+    std::vector<CsrGraph> graphs = {starGraph(300), perfectMatching(300), paleyGraph(101), gridGraph(9, 10, true),
+                                    cfiGraph(cycleGraph(12).view(), true), erdosRenyiGraph(200, 3.0, rng, 2)};
+    for (const CsrGraph& g : graphs) {
+        CanonicalForm sequential = canonicalForm(g.view());
+        CanonicalForm parallel = canonicalForm(relabeledGraph(g, rng).view(), options);
+        CHECK(parallel == sequential);
+        CanonicalForm own = canonicalForm(g.view(), options);
+        for (const std::vector<int>& gen : own.generators) CHECK(isAutomorphism(g, gen));
+        CHECK(automorphismOrbits(g.numVertices(), own.generators) ==
+              automorphismOrbits(g.numVertices(), sequential.generators));
+    }
+}
+
+TEST_CASE(orbitsOfStar) {
+    CanonicalForm form = canonicalForm(starGraph(30).view());
+    std::vector<int> orbits = automorphismOrbits(30, form.generators);
+    CHECK(orbits[0] == 0);
+    for (int v = 1; v < 30; ++v) CHECK(orbits[v] == 1);
+}
+
+// Stars, edgeless graphs and perfect matchings have huge automorphism
+// groups; before orbit pruning kept a node cheap, a 500-vertex star took
+// most of a minute.
+TEST_CASE(highlySymmetricGraphsStayFast) {
+    const int n = 2000;
+    for (const CsrGraph& g : {starGraph(n), edgelessGraph(n), perfectMatching(n)}) {
+        auto start = std::chrono::steady_clock::now();
+        expectCanonicalUnderRelabeling(g);
+        CHECK(secondsSince(start) < 10.0);
+    }
+}
+
+int main() {
+    return runTests();
+}
@@ -0,0 +1,93 @@
+#include <random>
+#include "graph_generators.h"
+#include "graph_utils.h"
+#include "iso_stats.h"
+#include "test_graphs.h"
+#include "test_support.h"
+
+// Whether mapping carries every edge of g1 onto an edge of g2 with the
+// same weight.
+static bool isIsomorphism(const CsrGraph& g1, const CsrGraph& g2, const std::vector<int>& mapping) {
+    if (static_cast<int>(mapping.size()) != g1.numVertices()) return false;
+    for (const CsrEdge& e : csrEdges(g1)) {
+        if (g2.weight(mapping[e.from], mapping[e.to]) != e.weight) return false;
+    }
+    return true;
+}
+
+TEST_CASE(smallPairs) {
+    std::vector<CsrEdge> triangles;
+    for (int base : {0, 3}) {
+        for (int i = 0; i < 3; ++i) addUndirectedEdge(triangles, base + i, base + (i + 1) % 3);
+    }
+    CHECK(!areGraphsIsomorphic(cycleGraph(6).view(), CsrGraph::fromEdges(6, triangles).view()));
+    CHECK(!areGraphsIsomorphic(starGraph(6).view(), cycleGraph(6).view()));
+
+    std::mt19937_64 rng(5);
+    for (int i = 0; i < 20; ++i) {
+        CsrGraph g = erdosRenyiGraph(40, 3.0, rng, 3);
+        CsrGraph h = relabeledGraph(g, rng);
+        IsoMapping m = findIsomorphism(g.view(), h.view());
+        CHECK(m.isomorphic);
+        CHECK(isIsomorphism(g, h, m.mapping));
+    }
+}
+
+// Sparse random graphs are mostly a giant component with trees hanging
+// off it plus many small components; the stable coloring pins nearly
+// every vertex, so the matcher decides them without backtracking instead
+// of running out of budget and falling back to canonical forms.
+TEST_CASE(largeSparseGraphsStayInTheMatcher) {
+    std::mt19937_64 rng(42);
+    CsrGraph g = erdosRenyiGraph(200000, 6.0, rng);
+    CsrGraph h = relabeledGraph(g, rng);
+    IsoStats stats;
+    IsoOptions options;
+    options.stats = &stats;
+    IsoMapping m = findIsomorphism(g.view(), h.view(), options);
+    CHECK(m.isomorphic);
+    CHECK(isIsomorphism(g, h, m.mapping));
+    CHECK(stats.decidedBy == IsoStats::Decider::Matcher);
+    if (isoStatsCounted()) CHECK(stats.backtracks < 1000);
+
+    CsrGraph near = relabeledGraph(nearMissGraph(g, rng), rng);
+    CHECK(!areGraphsIsomorphic(g.view(), near.view()));
+}
+
+// The group is only computed for isomorphic pairs; a rejected pair costs
+// no canonical labeling of the first graph.
+TEST_CASE(automorphismsOnlyForIsomorphicPairs) {
+    std::mt19937_64 rng(9);
+    CsrGraph star = starGraph(300);
+    IsoOptions options;
+    options.automorphisms = true;
+
+    IsoMapping same = findIsomorphism(star.view(), relabeledGraph(star, rng).view(), options);
+    CHECK(same.isomorphic);
+    CHECK(!same.generators.empty());
+    for (const std::vector<int>& gen : same.generators) CHECK(isIsomorphism(star, star, gen));
+    CHECK(same.orbits.size() == 300u);
+    for (int v = 2; v < 300; ++v) CHECK(same.orbits[v] == same.orbits[1]);
+
+    std::vector<CsrEdge> edges = csrEdges(star);
+    addUndirectedEdge(edges, 1, 2);
+    CsrGraph other = CsrGraph::fromEdges(300, edges);
+    IsoMapping different = findIsomorphism(star.view(), other.view(), options);
+    CHECK(!different.isomorphic);
+    CHECK(different.generators.empty());
+    CHECK(different.orbits.empty());
+
+    // The matrix overload settles these before checkPair runs.
+    Graph matrix = star.toGraph();
+    IsoMapping identical = findIsomorphism(matrix, matrix, options);
+    CHECK(identical.isomorphic);
+    CHECK(identical.orbits.size() == 300u);
+    IsoMapping smaller = findIsomorphism(matrix, starGraph(299).toGraph(), options);
+    CHECK(!smaller.isomorphic);
+    CHECK(smaller.generators.empty());
+    CHECK(smaller.orbits.empty());
+}
+
+int main() {
+    return runTests();
+}
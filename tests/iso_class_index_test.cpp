@@ -0,0 +1,78 @@
+#include <cstdio>
+#include <random>
+#include "graph_generators.h"
+#include "iso_class_index.h"
+#include "test_graphs.h"
+#include "test_support.h"
+
+// Highly symmetric members, each under a few relabelings, plus graphs that
+// differ from them by one edge. Every fingerprint of the Canonical mode
+// runs the canonical search, which used to take seconds per 300-vertex
+// star.
+static std::vector<CsrGraph> symmetricCorpus(std::vector<int>& expectedClass) {
+    std::mt19937_64 rng(17);
+    std::vector<CsrGraph> bases = {starGraph(300), edgelessGraph(300), perfectMatching(300), cycleGraph(300),
+                                   paleyGraph(101), gridGraph(12, 12, true)};
+    std::vector<CsrEdge> edges = csrEdges(bases[0]);
+    addUndirectedEdge(edges, 1, 2);
+    bases.push_back(CsrGraph::fromEdges(300, edges));
+    edges = csrEdges(bases[2]);
+    addUndirectedEdge(edges, 1, 2);
+    bases.push_back(CsrGraph::fromEdges(300, edges));
+
+    std::vector<CsrGraph> corpus;
+    for (int copy = 0; copy < 3; ++copy) {
+        for (size_t b = 0; b < bases.size(); ++b) {
+            corpus.push_back(copy == 0 ? CsrGraph::fromEdges(bases[b].numVertices(), csrEdges(bases[b]))
+                                       : relabeledGraph(bases[b], rng));
+            expectedClass.push_back(static_cast<int>(b));
+        }
+    }
+    return corpus;
+}
+
+static void checkClassification(IsoClassIndex::Fingerprint mode, unsigned threads) {
+    std::vector<int> expected;
+    std::vector<CsrGraph> corpus = symmetricCorpus(expected);
+    std::vector<CsrView> views;
+    for (const CsrGraph& g : corpus) views.push_back(g.view());
+
+    IsoClassIndex index(mode);
+    IsoOptions options;
+    options.numThreads = threads;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<int> ids = index.insertBatch(views, options);
+    CHECK(secondsSince(start) < 10.0);
+    CHECK(ids == expected);
+    CHECK(index.numClasses() == 8u);
+    CHECK(index.numGraphs() == corpus.size());
+    for (size_t i = 0; i < corpus.size(); ++i) CHECK(index.find(views[i]) == expected[i]);
+}
+
+TEST_CASE(classifiesSymmetricCorpusByCanonicalForm) {
+    checkClassification(IsoClassIndex::Fingerprint::Canonical, 1);
+    checkClassification(IsoClassIndex::Fingerprint::Canonical, 4);
+}
+
+TEST_CASE(classifiesSymmetricCorpusByInvariants) {
+    checkClassification(IsoClassIndex::Fingerprint::Invariants, 1);
+}
+
+TEST_CASE(savedIndexKeepsClasses) {
+    std::vector<int> expected;
+    std::vector<CsrGraph> corpus = symmetricCorpus(expected);
+    IsoClassIndex index;
+    for (size_t i = 0; i < corpus.size() / 3; ++i) index.insert(corpus[i].view());
+
+    std::string path = "iso_class_index_test.idx";
+    index.save(path);
+    IsoClassIndex loaded = IsoClassIndex::load(path);
+    std::remove(path.c_str());
+    CHECK(loaded.fingerprint() == IsoClassIndex::Fingerprint::Canonical);
+    CHECK(loaded.numClasses() == index.numClasses());
+    for (size_t i = 0; i < corpus.size(); ++i) CHECK(loaded.find(corpus[i].view()) == expected[i]);
+}
+
+int main() {
+    return runTests();
+}
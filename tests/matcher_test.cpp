@@ -0,0 +1,94 @@
+#include <chrono>
+#include <random>
+#include "graph_generators.h"
+#include "graph_utils.h"
+#include "iso_stats.h"
+#include "matcher.h"
+#include "test_graphs.h"
+#include "test_support.h"
+
+// Paley graphs are strongly regular, so colors do not constrain the
+// matcher at all and it runs out of budget. With several threads the
+// tasks share the one budget of matcherBudget(n) steps and stop together,
+// so extra threads never add matcher work ahead of the canonical forms.
+TEST_CASE(parallelSearchStaysWithinBudget) {
+    std::mt19937_64 rng(11);
+    CsrGraph g = paleyGraph(401);
+    CsrGraph h = relabeledGraph(g, rng);
+    for (unsigned threads : {1u, 2u, 4u, 8u}) {
+        IsoStats stats;
+        IsoOptions options;
+        options.numThreads = threads;
+        options.stats = &stats;
+        auto start = std::chrono::steady_clock::now();
+        CHECK(areGraphsIsomorphic(g.view(), h.view(), options));
+        CHECK(secondsSince(start) < 5.0);
+        CHECK(stats.decidedBy == IsoStats::Decider::Canonical);
+        if (isoStatsCounted())
+            CHECK(stats.searchNodes + stats.backtracks <= matcherBudget(g.numVertices()));
+    }
+}
+
+// CFI pairs stay in the matcher but need real search; every thread count
+// has to give the same answers.
+TEST_CASE(parallelSearchAnswers) {
+    std::mt19937_64 rng(3);
+    CsrGraph base = cycleGraph(8);
+    CsrGraph plain = cfiGraph(base.view(), false);
+    CsrGraph twisted = cfiGraph(base.view(), true);
+    CsrGraph same = relabeledGraph(plain, rng);
+    for (unsigned threads : {1u, 2u, 4u}) {
+        IsoOptions options;
+        options.numThreads = threads;
+        IsoMapping m = findIsomorphism(plain.view(), same.view(), options);
+        CHECK(m.isomorphic);
+        for (const CsrEdge& e : csrEdges(plain)) CHECK(same.weight(m.mapping[e.from], m.mapping[e.to]) == e.weight);
+        CHECK(!areGraphsIsomorphic(plain.view(), twisted.view(), options));
+    }
+}
+
+// Orbit pruning lets the matcher settle CFI pairs over small bases, but
+// over a 16-vertex cubic base they still run out of budget and are left to
+// the canonical fallback.
+TEST_CASE(cfiDeciderWithAutomorphisms) {
+    std::mt19937_64 rng(5);
+    CsrGraph cycle = cycleGraph(8);
+    CsrGraph cubic = randomRegularGraph(16, 3, rng);
+    for (const CsrGraph* base : {&cycle, &cubic}) {
+        CsrGraph plain = cfiGraph(base->view(), false);
+        CsrGraph twisted = cfiGraph(base->view(), true);
+        CsrGraph same = relabeledGraph(plain, rng);
+        IsoStats::Decider expected = base == &cycle ? IsoStats::Decider::Matcher : IsoStats::Decider::Canonical;
+        for (const CsrGraph* other : {&same, &twisted}) {
+            IsoStats stats;
+            IsoOptions options;
+            options.automorphisms = true;
+            options.stats = &stats;
+            CHECK(areGraphsIsomorphic(plain.view(), other->view(), options) == (other == &same));
+            CHECK(stats.decidedBy == expected);
+        }
+    }
+}
+
+// Discrete refined colors mean a trivial group: no labeling is computed
+// up front or for the result.
+TEST_CASE(noLabelingForDiscreteColors) {
+    std::mt19937_64 rng(2);
+    CsrGraph g = erdosRenyiGraph(300, 8.0, rng, 3);
+    CsrGraph h = relabeledGraph(g, rng);
+    IsoStats stats;
+    IsoOptions options;
+    options.automorphisms = true;
+    options.stats = &stats;
+    IsoMapping m = findIsomorphism(g.view(), h.view(), options);
+    CHECK(m.isomorphic);
+    CHECK(stats.decidedBy == IsoStats::Decider::Matcher);
+    CHECK(m.generators.empty());
+    CHECK(m.orbits.size() == 300u);
+    for (int v = 0; v < 300; ++v) CHECK(m.orbits[v] == v);
+    if (isoStatsCounted()) CHECK(stats.canonicalNodes == 0);
+}
+
+int main() {
+    return runTests();
+}
@@ -0,0 +1,221 @@
+#include <atomic>
+#include <functional>
+#include <random>
+#include <set>
+#include "subgraph_iso.h"
+#include "test_support.h"
+
+// Random matrix with weights in [-maxWeight, maxWeight] \ {0}; symmetric
+// unless directed.
+static Graph randomGraph(std::mt19937& rng, int n, double p, bool directed, int maxWeight, bool loops) {
+    Graph g;
+    g.numVertices = n;
+    g.adjacencyMatrix.assign(n, std::vector<int>(n, 0));
+    std::uniform_real_distribution<double> coin;
+    std::uniform_int_distribution<int> weight(1, maxWeight);
+    for (int i = 0; i < n; ++i) {
+        for (int j = directed ? 0 : i; j < n; ++j) {
+            if ((i == j && !loops) || coin(rng) >= p) continue;
+            int w = coin(rng) < 0.25 ? -weight(rng) : weight(rng);
+            g.adjacencyMatrix[i][j] = w;
+            if (!directed) g.adjacencyMatrix[j][i] = w;
+        }
+    }
+    return g;
+}
+
+// The matching rule of one cell, straight from the header's description.
+static bool cellMatches(const SubgraphOptions& match, int patternWeight, int hostWeight) {
+    if (patternWeight == 0) return match.mode == SubgraphOptions::Mode::Subgraph || hostWeight == 0;
+    if (hostWeight == 0) return false;
+    return match.weights == SubgraphOptions::Weights::Exact ? hostWeight == patternWeight : hostWeight >= patternWeight;
+}
+
+static bool isEmbedding(const Graph& pattern, const Graph& host, const SubgraphOptions& match,
+                        const std::vector<int>& embedding) {
+    if (static_cast<int>(std::set<int>(embedding.begin(), embedding.end()).size()) != pattern.numVertices)
+        return false;
+    for (int i = 0; i < pattern.numVertices; ++i) {
+        for (int j = 0; j < pattern.numVertices; ++j) {
+            if (!cellMatches(match, pattern.adjacencyMatrix[i][j], host.adjacencyMatrix[embedding[i]][embedding[j]]))
+                return false;
+        }
+    }
+    return true;
+}
+
+static long long bruteForceCount(const Graph& pattern, const Graph& host, const SubgraphOptions& match) {
+    std::vector<int> embedding;
+    std::vector<char> used(host.numVertices, 0);
+    long long count = 0;
+    std::function<void()> extend = [&]() {
+        if (static_cast<int>(embedding.size()) == pattern.numVertices) {
+            count += isEmbedding(pattern, host, match, embedding);
+            return;
+        }
+        for (int v = 0; v < host.numVertices; ++v) {
+            if (used[v]) continue;
+            used[v] = 1;
+            embedding.push_back(v);
+            extend();
+            embedding.pop_back();
+            used[v] = 0;
+        }
+    };
+    extend();
+    return count;
+}
+
+static std::vector<SubgraphOptions> allMatchOptions() {
+    std::vector<SubgraphOptions> result;
+    for (auto mode : {SubgraphOptions::Mode::Subgraph, SubgraphOptions::Mode::Induced}) {
+        for (auto weights : {SubgraphOptions::Weights::Exact, SubgraphOptions::Weights::AtLeast}) {
+            SubgraphOptions match;
+            match.mode = mode;
+            match.weights = weights;
+            result.push_back(match);
+        }
+    }
+    return result;
+}
+
+// Random small pairs, directed and weighted ones included, against brute
+// force in every mode. Hosts this small stay on one thread whatever the
+// thread count; parallelMatchesSequential covers the split search.
+TEST_CASE(matchesBruteForce) {
+    std::mt19937 rng(7);
+    for (int round = 0; round < 400; ++round) {
+        bool directed = round % 3 == 0;
+        int maxWeight = round % 4 == 0 ? 3 : 1;
+        bool loops = round % 5 == 0;
+        int hostSize = 2 + static_cast<int>(rng() % 7);
+        int patternSize = 1 + static_cast<int>(rng() % std::min(hostSize, 4));
+        Graph host = randomGraph(rng, hostSize, 0.3 + 0.4 * (rng() % 100) / 100.0, directed, maxWeight, loops);
+        Graph pattern = randomGraph(rng, patternSize, 0.5, directed, maxWeight, loops);
+
+        for (const SubgraphOptions& match : allMatchOptions()) {
+            long long expected = bruteForceCount(pattern, host, match);
+            for (unsigned threads : {1u, 4u}) {
+                IsoOptions options;
+                options.numThreads = threads;
+                CHECK(countSubgraphs(pattern, host, match, options) == expected);
+
+                std::set<std::vector<int>> seen;
+                bool allValid = true;
+                long long passed = enumerateSubgraphs(pattern, host, match, [&](const std::vector<int>& embedding) {
+                    allValid = allValid && isEmbedding(pattern, host, match, embedding) && seen.insert(embedding).second;
+                    return true;
+                }, options);
+                CHECK(passed == expected);
+                CHECK(allValid);
+
+                std::vector<int> embedding;
+                bool found = findSubgraph(pattern, host, match, embedding, options);
+                CHECK(found == (expected > 0));
+                if (found) CHECK(isEmbedding(pattern, host, match, embedding));
+            }
+        }
+    }
+}
+
+// Hosts of 64 or more vertices are split over the threads. Every thread
+// count has to find the same embeddings, call back one at a time and stop
+// right after the callback asks it to.
+TEST_CASE(parallelMatchesSequential) {
+    std::mt19937 rng(5);
+    for (int round = 0; round < 12; ++round) {
+        bool directed = round % 3 == 0;
+        int maxWeight = round % 4 == 0 ? 2 : 1;
+        int hostSize = 64 + static_cast<int>(rng() % 40);
+        int patternSize = 3 + round % 2;
+        Graph host = randomGraph(rng, hostSize, 0.1, directed, maxWeight, round % 5 == 0);
+        // A path through the pattern keeps the embeddings few enough to
+        // collect.
+        Graph pattern = randomGraph(rng, patternSize, 0.5, directed, maxWeight, false);
+        for (int v = 0; v + 1 < patternSize; ++v) {
+            if (pattern.adjacencyMatrix[v][v + 1] != 0) continue;
+            pattern.adjacencyMatrix[v][v + 1] = 1;
+            if (!directed) pattern.adjacencyMatrix[v + 1][v] = 1;
+        }
+
+        for (const SubgraphOptions& match : allMatchOptions()) {
+            std::set<std::vector<int>> expected;
+            enumerateSubgraphs(pattern, host, match, [&](const std::vector<int>& embedding) {
+                expected.insert(embedding);
+                return true;
+            });
+            long long total = static_cast<long long>(expected.size());
+            CHECK(countSubgraphs(pattern, host, match) == total);
+
+            for (unsigned threads : {2u, 4u, 8u}) {
+                IsoOptions options;
+                options.numThreads = threads;
+                CHECK(countSubgraphs(pattern, host, match, options) == total);
+
+                std::set<std::vector<int>> seen;
+                std::atomic<int> inside{0};
+                bool serialized = true;
+                long long passed = enumerateSubgraphs(pattern, host, match, [&](const std::vector<int>& embedding) {
+                    serialized = serialized && inside.fetch_add(1) == 0;
+                    seen.insert(embedding);
+                    inside.fetch_sub(1);
+                    return true;
+                }, options);
+                CHECK(passed == total);
+                CHECK(serialized);
+                CHECK(seen == expected);
+
+                std::vector<int> embedding;
+                bool found = findSubgraph(pattern, host, match, embedding, options);
+                CHECK(found == (total > 0));
+                if (found) CHECK(expected.count(embedding) == 1);
+
+                const long long limit = 5;
+                long long calls = 0;
+                passed = enumerateSubgraphs(pattern, host, match, [&](const std::vector<int>& e) {
+                    CHECK(expected.count(e) == 1);
+                    return ++calls < limit;
+                }, options);
+                CHECK(calls == std::min(total, limit));
+                CHECK(passed == calls);
+            }
+        }
+    }
+}
+
+// A pattern loop must land on a host loop in every mode; in AtLeast mode a
+// negative pattern weight used to match the missing loop as weight 0.
+TEST_CASE(negativeLoopNeedsHostLoop) {
+    Graph pattern;
+    pattern.numVertices = 1;
+    pattern.adjacencyMatrix = {{-2}};
+    Graph host;
+    host.numVertices = 3;
+    host.adjacencyMatrix = {{0, 1, 0}, {1, -1, 0}, {0, 0, 0}};
+    for (const SubgraphOptions& match : allMatchOptions()) {
+        long long count = countSubgraphs(pattern, host, match);
+        CHECK(count == (match.weights == SubgraphOptions::Weights::AtLeast ? 1 : 0));
+    }
+}
+
+// A directed path into a larger directed host: arcs have to keep their
+// direction, so only the host's forward runs count.
+TEST_CASE(directedHostKeepsDirections) {
+    Graph pattern;
+    pattern.numVertices = 3;
+    pattern.adjacencyMatrix = {{0, 1, 0}, {0, 0, 1}, {0, 0, 0}};
+    Graph host;
+    host.numVertices = 70;
+    host.adjacencyMatrix.assign(70, std::vector<int>(70, 0));
+    for (int v = 0; v + 1 < 70; ++v) host.adjacencyMatrix[v][v + 1] = 1;
+    SubgraphOptions match;
+    CHECK(countSubgraphs(pattern, host, match) == 68);
+    match.mode = SubgraphOptions::Mode::Induced;
+    CHECK(countSubgraphs(pattern, host, match) == 68);
+    host.adjacencyMatrix[2][0] = 1;
+    CHECK(countSubgraphs(pattern, host, match) == 67);
+}
+
+int main() {
+    return runTests();
+}
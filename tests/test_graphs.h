@@ -0,0 +1,39 @@
+#ifndef TEST_GRAPHS_H
+#define TEST_GRAPHS_H
+
+// Small graph families shared by the tests.
+
+#include <vector>
+#include "csr_graph.h"
+
+inline void addUndirectedEdge(std::vector<CsrEdge>& edges, int u, int v, int weight = 1) {
+    edges.push_back({u, v, weight});
+    edges.push_back({v, u, weight});
+}
+
+// Vertex 0 joined to each of the other n - 1 vertices.
+inline CsrGraph starGraph(int n) {
+    std::vector<CsrEdge> edges;
+    for (int v = 1; v < n; ++v) addUndirectedEdge(edges, 0, v);
+    return CsrGraph::fromEdges(n, edges);
+}
+
+inline CsrGraph edgelessGraph(int n) {
+    return CsrGraph::fromEdges(n, {});
+}
+
+// Edges 2i -- 2i + 1; n should be even.
+inline CsrGraph perfectMatching(int n) {
+    std::vector<CsrEdge> edges;
+    for (int v = 0; v + 1 < n; v += 2) addUndirectedEdge(edges, v, v + 1);
+    return CsrGraph::fromEdges(n, edges);
+}
+
+// Cycle 0 -- 1 -- ... -- n - 1 -- 0.
+inline CsrGraph cycleGraph(int n) {
+    std::vector<CsrEdge> edges;
+    for (int v = 0; v < n; ++v) addUndirectedEdge(edges, v, (v + 1) % n);
+    return CsrGraph::fromEdges(n, edges);
+}
+
+#endif // TEST_GRAPHS_H
@@ -0,0 +1,79 @@
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+// Minimal test harness: TEST_CASE registers a function, CHECK records a
+// failure without stopping the case, and runTests runs every case and
+// returns the exit code.
+
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <vector>
+
+struct TestCase {
+    const char* name;
+    std::function<void()> run;
+};
+
+inline std::vector<TestCase>& testRegistry() {
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+struct TestRegistrar {
+    TestRegistrar(const char* name, std::function<void()> run) { testRegistry().push_back({name, std::move(run)}); }
+};
+
+#define TEST_CASE(name)                                   \
+    static void name();                                   \
+    static TestRegistrar name##Registrar(#name, name);    \
+    static void name()
+
+#define CHECK(condition)                                                                    \
+    do {                                                                                    \
+        if (!(condition)) {                                                                 \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++testFailures();                                                               \
+        }                                                                                   \
+    } while (0)
+
+#define CHECK_THROWS(expression)                                                             \
+    do {                                                                                     \
+        bool threw = false;                                                                  \
+        try {                                                                                \
+            (void)(expression);                                                              \
+        } catch (...) {                                                                      \
+            threw = true;                                                                    \
+        }                                                                                    \
+        if (!threw) {                                                                        \
+            std::fprintf(stderr, "%s:%d: expected an exception: %s\n", __FILE__, __LINE__, #expression); \
+            ++testFailures();                                                                \
+        }                                                                                    \
+    } while (0)
+
+// Seconds since `start`, for the runtime regression checks.
+inline double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline int runTests() {
+    for (const TestCase& test : testRegistry()) {
+        int before = testFailures();
+        try {
+            test.run();
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "%s: unexpected exception: %s\n", test.name, e.what());
+            ++testFailures();
+        }
+        std::printf("%s %s\n", testFailures() == before ? "[  OK  ]" : "[FAILED]", test.name);
+    }
+    return testFailures() == 0 ? 0 : 1;
+}
+
+#endif // TEST_SUPPORT_H
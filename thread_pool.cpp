@@ -0,0 +1,79 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(unsigned numThreads) {
+    numThreads = std::max(1u, numThreads);
+    for (unsigned i = 0; i < numThreads; ++i) queues.push_back(std::make_unique<Queue>());
+    for (unsigned i = 0; i < numThreads; ++i) workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : workers) t.join();
+}
+
+void WorkStealingPool::submit(Task task) {
+    {
+        // Counted under stateMutex so a worker about to sleep sees it.
+        std::lock_guard<std::mutex> lock(stateMutex);
+        Queue& q = *queues[nextQueue];
+        nextQueue = (nextQueue + 1) % queues.size();
+        {
+            std::lock_guard<std::mutex> queueLock(q.mutex);
+            q.tasks.push_back(std::move(task));
+        }
+        ++pending;
+        ++queued;
+    }
+    wake.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    idle.wait(lock, [this] { return pending == 0; });
+}
+
+bool WorkStealingPool::takeTask(unsigned worker, Task& task) {
+    size_t count = queues.size();
+    for (size_t i = 0; i < count; ++i) {
+        Queue& q = *queues[(worker + i) % count];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) continue;
+        if (i == 0) {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+        } else {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+        }
+        --queued;
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(unsigned worker) {
+    while (true) {
+        Task task;
+        if (takeTask(worker, task)) {
+            task(worker);
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (--pending == 0) idle.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(stateMutex);
+        wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) return;
+    }
+}
+
+unsigned resolveThreadCount(unsigned requested) {
+    if (requested > 0) return requested;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
@@ -0,0 +1,58 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool with one task deque per worker. Submitted tasks are dealt
+// round-robin; a worker takes from the front of its own deque and, once it
+// runs dry, steals from the back of the others.
+class WorkStealingPool {
+public:
+    // A task receives the index of the worker running it, so callers can
+    // keep per-worker scratch state without locking.
+    using Task = std::function<void(unsigned worker)>;
+
+    explicit WorkStealingPool(unsigned numThreads);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+    void submit(Task task);
+    // Blocks until every submitted task has finished.
+    void wait();
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex stateMutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::atomic<long> queued{0};  // may dip below zero while a push is in flight
+    size_t pending = 0;
+    unsigned nextQueue = 0;
+    bool stopping = false;
+
+    bool takeTask(unsigned worker, Task& task);
+    void workerLoop(unsigned worker);
+};
+
+// Resolves a requested thread count: 0 means one per hardware thread.
+unsigned resolveThreadCount(unsigned requested);
+
+#endif // THREAD_POOL_H